@@ -47,6 +47,7 @@
 
 // KDChart
 #include <KDChartChart>
+#include <KDChartAttributesModel>
 #include <KDChartLegend>
 #include <KDChartCartesianAxis>
 #include <KDChartCartesianCoordinatePlane>
@@ -259,6 +260,8 @@ void Axis::Private::registerDiagram(KDChart::AbstractDiagram *diagram)
 {
     KDChartModel *model = new KDChartModel;
     diagram->setModel(model);
+    // Spare the attributes model asking for attributes we never provide
+    diagram->attributesModel()->setSourceModelAttributesRoles(KDChartModel::attributesRoles());
 
     QObject::connect(plotArea->proxyModel(), SIGNAL(columnsInserted(const QModelIndex&, int, int)),
                       model,                  SLOT(slotColumnsInserted(const QModelIndex&, int, int)));
@@ -23,15 +23,13 @@
 // Own
 #include "CellRegion.h"
 
-// C
-#include <cmath>
-
 // Qt
 #include <QPoint>
 #include <QRect>
 #include <QVector>
 #include <QDebug>
 #include <QStringList>
+#include <QtAlgorithms>
 
 // KDE
 #include <kdebug.h>
@@ -40,9 +38,6 @@
 #include "TableSource.h"
 
 
-using std::pow;
-
-static QString columnName(uint column);
 //static int rangeCharToInt(char c);
 
 /**
@@ -78,20 +73,139 @@ static QString unformatTableName(QString name)
     return name;
 }
 
-class CellRegion::Private
+/**
+ * Returns the number of indices a single rectangle of a region occupies.
+ * See pointAtIndex() for how 2-dimensional rectangles are treated.
+ */
+static inline int rectIndexCount(const QRect &rect)
+{
+    return qMax(0, rect.width() > 1 ? rect.width() : rect.height());
+}
+
+static inline bool isRangeSeparator(const QChar &c)
+{
+    return c == QLatin1Char(' ') || c == QLatin1Char(';');
+}
+
+/**
+ * Splits the cell address in [begin, end), e.g. $Sheet1.$B$3, at the
+ * last '.' that is not part of a quoted sheet name.
+ *
+ * Returns the start of the cell part and sets @a sheetEnd to the end of
+ * the sheet name, which is @a begin if there is none.
+ */
+static const QChar *splitSheetName(const QChar *begin, const QChar *end, const QChar **sheetEnd)
+{
+    const QChar *dot = 0;
+    bool quoted = false;
+    for (const QChar *pos = begin; pos < end; ++pos) {
+        if (*pos == QLatin1Char('\''))
+            quoted = !quoted;
+        else if (*pos == QLatin1Char('.') && !quoted)
+            dot = pos;
+    }
+
+    if (!dot) {
+        *sheetEnd = begin;
+        return begin;
+    }
+    *sheetEnd = dot;
+    return dot + 1;
+}
+
+/**
+ * Parses a cell address without sheet name like $AB$12 or AB12 in
+ * [pos, end) and stores the column and row in @a point.
+ *
+ * Returns false if there's no valid address at @a pos.
+ */
+static bool parseCellAddress(const QChar *pos, const QChar *end, QPoint *point)
+{
+    int column = 0;
+    int row = 0;
+
+    if (pos < end && *pos == QLatin1Char('$'))
+        ++pos;
+    const QChar *columnStart = pos;
+    for (; pos < end && pos->unicode() >= 'A' && pos->unicode() <= 'Z'; ++pos)
+        column = column * 26 + pos->unicode() - 'A' + 1;
+    if (pos == columnStart)
+        return false;
+
+    if (pos < end && *pos == QLatin1Char('$'))
+        ++pos;
+    const QChar *rowStart = pos;
+    for (; pos < end && pos->unicode() >= '0' && pos->unicode() <= '9'; ++pos)
+        row = row * 10 + pos->unicode() - '0';
+    if (pos == rowStart)
+        return false;
+
+    point->setX(column);
+    point->setY(row);
+    return true;
+}
+
+/**
+ * Appends the symbolic name of a column, e.g. AB for column 28.
+ */
+static void appendColumnName(QString &string, int column)
+{
+    if (column < 1 || column > 32767) {
+        string.append(QLatin1String("@@@"));
+        return;
+    }
+
+    // Bijective base 26, least significant digit first
+    QChar digits[4];
+    int count = 0;
+    for (; column > 0; column /= 26) {
+        --column;
+        digits[count++] = QLatin1Char(char('A' + column % 26));
+    }
+    while (count > 0)
+        string.append(digits[--count]);
+}
+
+static void appendPoint(QString &string, const QPoint &point)
+{
+    string.append(QLatin1Char('$'));
+    appendColumnName(string, point.x());
+    string.append(QLatin1Char('$'));
+
+    if (point.y() < 0) {
+        string.append(QString::number(point.y()));
+        return;
+    }
+
+    QChar digits[10];
+    int count = 0;
+    int row = point.y();
+    do {
+        digits[count++] = QLatin1Char(char('0' + row % 10));
+        row /= 10;
+    } while (row > 0);
+    while (count > 0)
+        string.append(digits[--count]);
+}
+
+class CellRegion::Private : public QSharedData
 {
 public:
     Private();
     ~Private();
 
-    QString pointToString(const QPoint &point) const;
-
     // These are actually one-dimensional, but can have different
     // orientations (hor / vert).
     QVector<QRect> rects;
 
     QRect          boundingRect;
-    // NOTE: Don't forget to extend operator=() if you add new members
+
+    // Prefix sums of the number of indices in each rectangle, i.e.
+    // offsets[i] is the index of the first point in rects[i]. Has one
+    // more entry than rects, the last one being the total index count.
+    QVector<int>   offsets;
+    // NOTE: Private is copied on write by QSharedDataPointer, so all
+    // members must be copyable.
 
     /// Table this region is in (name/model pair provided by TableSource)
     Table *table;
@@ -101,6 +215,7 @@ public:
 CellRegion::Private::Private()
 {
     table = 0;
+    offsets.append(0);
 }
 
 CellRegion::Private::~Private()
@@ -118,55 +233,96 @@ CellRegion::CellRegion()
 }
 
 CellRegion::CellRegion(const CellRegion &region)
-    : d(new Private())
+    : d(region.d)
 {
-    // Use operator=();
-    *this = region;
 }
 
 CellRegion::CellRegion(TableSource *source, const QString& regions)
     : d(new Private())
 {
     // A dollar sign before a part of the address means that this part
-    // is absolute. This is irrelevant for us, however, thus we can remove
+    // is absolute. This is irrelevant for us, however, thus we can skip
     // all occurences of '$', and handle relative and absolute addresses in
     // the same way.
     // See ODF specs $8.3.1 "Referencing Table Cells"
-    QStringList regionsList = regions.split(" ", QString::SkipEmptyParts);
-    Q_FOREACH(const QString& region, regionsList) {
-      QString searchStr = QString(region).remove("$");
-      QRegExp regEx;
-
-      QStringList regionList = searchStr.split(";");
-      Q_FOREACH(const QString &region, regionList) {
-          const bool isPoint = !region.contains(':');
-          if (isPoint)
-              regEx = QRegExp("(|.*\\.)([A-Z]+)([0-9]+)");
-          else // support range-notations like Sheet1.D2:Sheet1.F2 Sheet1.D2:F2 D2:F2
-              regEx = QRegExp ("(|.*\\.)([A-Z]+)([0-9]+)\\:(|.*\\.)([A-Z]+)([0-9]+)");
-
-          // Check if region string is valid (e.g. not empty)
-          if (regEx.indexIn(region) >= 0) {
-              // It is possible for a cell-range-address as defined in ODF to contain
-              // refernces to cells of more than one sheet. This, however, we ignore
-              // here. We do not support more than one table in a cell region.
-              // Also we do not support regions spanned over different sheets. For us
-              // everything is either on no sheet or on the same sheet.
-              QString sheetName = regEx.cap(1);
-              if (sheetName.endsWith("."))
-                  sheetName = sheetName.left(sheetName.length() - 1);
-              // TODO: Support for multiple tables in one region
-              d->table = source->get(unformatTableName(sheetName));
-
-              QPoint topLeft(rangeStringToInt(regEx.cap(2)), regEx.cap(3).toInt());
-              if (isPoint) {
-                  d->rects.append(QRect(topLeft, QSize(1, 1)));
-              } else {
-                  QPoint bottomRight(rangeStringToInt(regEx.cap(5)), regEx.cap(6).toInt());
-                  d->rects.append(QRect(topLeft, bottomRight));
-              }
-          }
-      }
+    //
+    // This is a single pass over the string that avoids creating temporary
+    // strings for the parts of the address. Regions in a document can have
+    // many sub-regions, and a document can have many regions, so this
+    // matters for the time it takes to load a chart.
+    const QChar *pos = regions.constData();
+    const QChar *const end = pos + regions.length();
+
+    // Usually all sub-regions lie on the same sheet, so the table of the
+    // last sheet name is cached and only looked up again when the sheet
+    // name changes. This is not an intern table: regions alternating
+    // between sheets look up the table for every sub-region.
+    QString lastSheetName;
+    Table *lastTable = 0;
+    bool haveLastTable = false;
+
+    while (pos < end) {
+        // Find the end of this sub-region and the ':' separating its corners.
+        // Quoted sheet names may contain any of these characters.
+        const QChar *rangeEnd = pos;
+        const QChar *colon = 0;
+        bool quoted = false;
+        for (; rangeEnd < end; ++rangeEnd) {
+            if (*rangeEnd == QLatin1Char('\''))
+                quoted = !quoted;
+            else if (quoted)
+                continue;
+            else if (isRangeSeparator(*rangeEnd))
+                break;
+            else if (*rangeEnd == QLatin1Char(':') && !colon)
+                colon = rangeEnd;
+        }
+
+        // Support range-notations like Sheet1.D2:Sheet1.F2 Sheet1.D2:F2 D2:F2
+        const QChar *topLeftEnd = colon ? colon : rangeEnd;
+        const QChar *sheetEnd;
+        const QChar *cell = splitSheetName(pos, topLeftEnd, &sheetEnd);
+
+        QPoint topLeft;
+        QPoint bottomRight;
+        bool valid = parseCellAddress(cell, topLeftEnd, &topLeft);
+        if (valid && colon) {
+            // The sheet name of the second corner is ignored, see below
+            const QChar *bottomRightSheetEnd;
+            const QChar *bottomRightCell = splitSheetName(colon + 1, rangeEnd, &bottomRightSheetEnd);
+            valid = parseCellAddress(bottomRightCell, rangeEnd, &bottomRight);
+        }
+
+        // Check if region string is valid (e.g. not empty)
+        if (valid) {
+            // It is possible for a cell-range-address as defined in ODF to contain
+            // refernces to cells of more than one sheet. This, however, we ignore
+            // here. We do not support more than one table in a cell region.
+            // Also we do not support regions spanned over different sheets. For us
+            // everything is either on no sheet or on the same sheet.
+            const QChar *sheetStart = pos;
+            while (sheetStart < sheetEnd && *sheetStart == QLatin1Char('$'))
+                ++sheetStart;
+            // Refers to the characters in regions, no copy is made
+            QString sheetName = QString::fromRawData(sheetStart, sheetEnd - sheetStart);
+            if (!haveLastTable || sheetName != lastSheetName) {
+                QString tableName = sheetName;
+                if (tableName.contains(QLatin1Char('$')))
+                    tableName = QString(tableName).remove(QLatin1Char('$'));
+                // TODO: Support for multiple tables in one region
+                lastTable = source->get(unformatTableName(tableName));
+                lastSheetName = sheetName;
+                haveLastTable = true;
+            }
+            d->table = lastTable;
+
+            if (colon)
+                add(QRect(topLeft, bottomRight));
+            else
+                add(QRect(topLeft, QSize(1, 1)));
+        }
+
+        pos = rangeEnd + 1;
     }
 }
 
@@ -200,15 +356,12 @@ CellRegion::CellRegion(Table *table)
 
 CellRegion::~CellRegion()
 {
-    delete d;
 }
 
 
 CellRegion& CellRegion::operator = (const CellRegion& region)
 {
-    d->rects        = region.d->rects;
-    d->boundingRect = region.d->boundingRect;
-    d->table = region.d->table;
+    d = region.d;
 
     return *this;
 }
@@ -244,38 +397,34 @@ bool CellRegion::isValid() const
     return d->rects.size() > 0 && d->table ;
 }
 
-QString CellRegion::Private::pointToString(const QPoint &point) const
-{
-    QString result;
-
-    result.append('$' + columnName(point.x()));
-    result.append('$' + QString::number(point.y()));
-
-    return result;
-}
-
 QString CellRegion::toString() const
 {
     if (!isValid())
         return QString();
 
+    // All ranges are in the same table, so format its name only once
+    QString sheetName;
+    if (table())
+        sheetName = '$' + formatTableName(table()->name()) + '.';
+
     QString result;
+    // Enough for a sheet name and two addresses like $ABC$123456 per range
+    result.reserve(d->rects.count() * (sheetName.length() + 24));
     for (int i = 0; i < d->rects.count(); ++i) {
-        const QRect range = d->rects[i];
+        const QRect &range = d->rects[i];
         // Top-left corner
-        if (table())
-            result.append('$' + formatTableName(table()->name()) + '.');
-        result.append(d->pointToString(range.topLeft()));
+        result.append(sheetName);
+        appendPoint(result, range.topLeft());
 
         // If it is not a point, append rect's bottom-right corner
         if (range.topLeft() != range.bottomRight()) {
-            result.append(':');
-            result.append(d->pointToString(range.bottomRight()));
+            result.append(QLatin1Char(':'));
+            appendPoint(result, range.bottomRight());
         }
 
         // Separate ranges by a comma, except for the last one
         if (i < d->rects.count() - 1)
-            result.append(';');
+            result.append(QLatin1Char(';'));
     }
     return result;
 }
@@ -388,6 +537,7 @@ void CellRegion::add(const QRect &rect)
 
     d->rects.append(rect);
     d->boundingRect |= rect;
+    d->offsets.append(d->offsets.last() + rectIndexCount(rect));
 }
 
 void CellRegion::add(const QVector<QRect> &rects)
@@ -403,140 +553,161 @@ QRect CellRegion::boundingRect() const
 
 bool CellRegion::hasPointAtIndex(int index) const
 {
-    return pointAtIndex(index) != QPoint(-1, -1);
+    return index >= 0 && index < d->offsets.last();
 }
 
 QPoint CellRegion::pointAtIndex(int index) const
 {
-    // sum of all previous rectangle indices
-    int i = 0;
-
-    foreach (const QRect &rect, d->rects) {
-        // Rectangle is horizontal
-        if (rect.width() > 1) {
-            // Found it!
-            // Index refers to point in current rectangle
-            if (i + rect.width() > index) {
-                // Local index of point in this rectangle
-                int j = index - i;
-                return QPoint(rect.x() + j, rect.y());
-            }
+    // Invalid index!
+    if (!hasPointAtIndex(index))
+        return QPoint(-1, -1);
 
-            // add number of indices in current rectangle to total index count
-            i += rect.width();
-        }
-        else {
-            // Found it!
-            // Index refers to point in current rectangle
-            if (i + rect.height() > index) {
-                // Local index of point in this rectangle
-                int j = index - i;
-                return QPoint(rect.x(), rect.y() + j);
-            }
+    // Find the last rectangle starting at or before index. Empty
+    // rectangles share their offset with the next one, qUpperBound()
+    // makes sure we skip those.
+    QVector<int>::const_iterator it = qUpperBound(d->offsets.constBegin(),
+                                                  d->offsets.constEnd(), index) - 1;
+    const int i = it - d->offsets.constBegin();
+    const QRect &rect = d->rects[i];
 
-            // add number of indices in current rectangle to total index count
-            i += rect.height();
-        }
-    }
+    // Local index of point in this rectangle
+    const int j = index - *it;
 
-    // Invalid index!
-    return QPoint(-1, -1);
+    // Rectangle is horizontal
+    if (rect.width() > 1)
+        return QPoint(rect.x() + j, rect.y());
+    return QPoint(rect.x(), rect.y() + j);
 }
 
 int CellRegion::indexAtPoint(const QPoint &point) const
 {
-    int indicesLeftToPoint = 0;
-    bool found = false;
-
-    foreach (const QRect &rect, d->rects) {
-        if (!rect.contains(point)) {
-            indicesLeftToPoint += rect.width() > 1 ? rect.width() : rect.height();
+    // Rectangles can lie anywhere in the table, so there is no order to
+    // search in. But finding the one containing point is cheap, and the
+    // offset table spares us from summing up all rectangles before it.
+    const int count = d->rects.count();
+    for (int i = 0; i < count; ++i) {
+        const QRect &rect = d->rects[i];
+        if (!rect.contains(point))
             continue;
-        }
 
-        found = true;
         if (rect.width() > 1)
-            indicesLeftToPoint += point.x() - rect.topLeft().x();
-        else
-            indicesLeftToPoint += point.y() - rect.topLeft().y();
+            return d->offsets[i] + point.x() - rect.x();
+        return d->offsets[i] + point.y() - rect.y();
     }
 
-    return found ? indicesLeftToPoint : -1;
+    return -1;
 }
 
-#if 0 // Unused?
-static int rangeCharToInt(char c)
+CellRegion::const_iterator CellRegion::begin() const
 {
-    return (c >= 'A' && c <= 'Z') ? (c - 'A' + 1) : -1;
+    return const_iterator(this, 0, 0);
 }
 
-static int rangeStringToInt(const QString &string)
+CellRegion::const_iterator CellRegion::end() const
 {
-    int result = 0;
-    const int size = string.size();
-    for (int i = 0; i < size; i++) {
-        //kDebug(350001) << "---" << float(rangeCharToInt(string[i].toAscii()) * pow(10.0, (size - i - 1)));
-        result += rangeCharToInt(string[i].toAscii()) * pow(10.0, (size - i - 1));
-    }
-    //kDebug(350001) << "+++++ result=" << result;
-    return result;
+    return const_iterator(this, d->rects.count(), 0);
 }
 
-static QString rangeIntToString(int i)
+CellRegion::const_iterator CellRegion::iteratorAt(int index) const
 {
-    QString tmp = QString::number(i);
-    for (int j = 0; j < tmp.size(); j++) {
-        tmp[j] = 'A' + tmp[j].toAscii() - '1';
-    }
+    if (!hasPointAtIndex(index))
+        return end();
 
-    //kDebug(350001) << "tmp=" << tmp;
-    return tmp;
+    QVector<int>::const_iterator it = qUpperBound(d->offsets.constBegin(),
+                                                  d->offsets.constEnd(), index) - 1;
+    return const_iterator(this, it - d->offsets.constBegin(), index - *it);
 }
-#endif
 
-int CellRegion::rangeCharToInt(char c)
+
+// ================================================================
+//                 Class CellRegion::const_iterator
+
+
+CellRegion::const_iterator::const_iterator()
+    : m_region(0)
+    , m_rect(0)
+    , m_offset(0)
 {
-    return (c >= 'A' && c <= 'Z') ? (c - 'A' + 1) : -1;
 }
 
-int CellRegion::rangeStringToInt(const QString &string)
+CellRegion::const_iterator::const_iterator(const CellRegion *region, int rect, int offset)
+    : m_region(region)
+    , m_rect(rect)
+    , m_offset(offset)
 {
-    int result = 0;
-    const int size = string.size();
-    for (int i = 0; i < size; i++) {
-        result += rangeCharToInt(string[i].toAscii()) * pow(10.0, (size - i - 1));
+    skipEmptyRects();
+}
+
+void CellRegion::const_iterator::skipEmptyRects()
+{
+    const QVector<QRect> &rects = m_region->d->rects;
+    while (m_rect < rects.count() && m_offset >= rectIndexCount(rects[m_rect])) {
+        ++m_rect;
+        m_offset = 0;
     }
+}
 
-    return result;
+QPoint CellRegion::const_iterator::operator*() const
+{
+    Q_ASSERT(m_region && m_rect < m_region->d->rects.count());
+    const QRect &rect = m_region->d->rects[m_rect];
+    if (rect.width() > 1)
+        return QPoint(rect.x() + m_offset, rect.y());
+    return QPoint(rect.x(), rect.y() + m_offset);
 }
 
-QString CellRegion::rangeIntToString(int i)
+CellRegion::const_iterator &CellRegion::const_iterator::operator++()
 {
-    QString tmp = QString::number(i);
-    for (int j = 0; j < tmp.size(); j++) {
-        tmp[j] = 'A' + tmp[j].toAscii() - '1';
-    }
+    ++m_offset;
+    skipEmptyRects();
+    return *this;
+}
 
-    return tmp;
+CellRegion::const_iterator CellRegion::const_iterator::operator++(int)
+{
+    const_iterator it(*this);
+    ++*this;
+    return it;
 }
 
-// Return the symbolic name of any column.
-static QString columnName(uint column)
+bool CellRegion::const_iterator::operator==(const const_iterator &other) const
 {
-    if (column < 1 || column > 32767)
-        return QString("@@@");
+    return m_region == other.m_region && m_rect == other.m_rect && m_offset == other.m_offset;
+}
 
-    QString   str;
-    unsigned  digits = 1;
-    unsigned  offset = 0;
+bool CellRegion::const_iterator::operator!=(const const_iterator &other) const
+{
+    return !(*this == other);
+}
 
-    column--;
+int CellRegion::const_iterator::index() const
+{
+    return m_region->d->offsets[m_rect] + m_offset;
+}
 
-    for (unsigned limit = 26; column >= limit + offset; limit *= 26, ++digits)
-        offset += limit;
+int CellRegion::rangeCharToInt(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (c - 'A' + 1) : -1;
+}
 
-    for (unsigned col = column - offset; digits; --digits, col /= 26)
-        str.prepend(QChar('A' + (col % 26)));
+int CellRegion::rangeStringToInt(const QString &string)
+{
+    // Bijective base 26, the same as parseCellAddress()
+    int result = 0;
+    const int size = string.size();
+    for (int i = 0; i < size; i++) {
+        const int digit = rangeCharToInt(string[i].toAscii());
+        if (digit < 0)
+            return -1;
+        result = result * 26 + digit;
+    }
+
+    return size > 0 ? result : -1;
+}
 
-    return str;
+QString CellRegion::rangeIntToString(int i)
+{
+    QString result;
+    appendColumnName(result, i);
+    return result;
 }
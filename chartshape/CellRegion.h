@@ -26,6 +26,7 @@
 #include <Qt>
 #include <QVector>
 #include <QRect>
+#include <QSharedDataPointer>
 
 #include "ChartShape.h"
 
@@ -63,6 +64,9 @@ class QPoint;
  * cells, as in most cases, or a more complex discontinuous region.
  * In its second form, the orientation of each separate continuous
  * region can vary, as well as their sizes.
+ *
+ * CellRegion is implicitly shared, copying it is cheap. Its data is
+ * only copied when a shared instance is modified through add().
  */
 
 // Definition in TableSource.h
@@ -112,17 +116,76 @@ public:
 
     QRect boundingRect() const;
 
+    /**
+     * Index lookups are done through a table of rectangle offsets that
+     * is kept up to date by add(), so these are O(log n) in the number
+     * of rectangles rather than a walk over all of them.
+     */
     bool   hasPointAtIndex(int index) const;
     QPoint pointAtIndex(int index) const;
     int    indexAtPoint(const QPoint &point) const;
 
+    /**
+     * Walks all points of this region in index order, i.e. the i-th
+     * point visited is pointAtIndex(i), without doing a lookup for
+     * every single index.
+     *
+     * Note that the iterator refers to this region's data and is
+     * invalidated by any call to add().
+     */
+    class CHARTSHAPE_TEST_EXPORT const_iterator
+    {
+    public:
+        const_iterator();
+
+        QPoint operator*() const;
+        const_iterator &operator++();
+        const_iterator operator++(int);
+        bool operator==(const const_iterator &other) const;
+        bool operator!=(const const_iterator &other) const;
+
+        /// The index of the current point in the region
+        int index() const;
+
+    private:
+        friend class CellRegion;
+        const_iterator(const CellRegion *region, int rect, int offset);
+        void skipEmptyRects();
+
+        const CellRegion *m_region;
+        int m_rect;
+        int m_offset;
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    /**
+     * Returns an iterator pointing to the point at @a index, or end()
+     * if there is no such point.
+     */
+    const_iterator iteratorAt(int index) const;
+    const_iterator constBegin() const { return begin(); }
+    const_iterator constEnd() const { return end(); }
+
+    /**
+     * Returns the value of a column letter, i.e. 1 for A up to 26 for Z,
+     * or -1 if @a c is no column letter.
+     */
     static int rangeCharToInt(char c);
+    /**
+     * Returns the number of the column named @a string, e.g. 28 for AB,
+     * or -1 if it is no column name. Columns are named like in
+     * toString().
+     */
     static int rangeStringToInt(const QString &string);
+    /**
+     * Returns the name of column @a i, e.g. AB for 28.
+     */
     static QString rangeIntToString(int i);
 
 private:
     class Private;
-    Private *const d;
+    QSharedDataPointer<Private> d;
 };
 
 #endif // KCHART_CELLREGION_H
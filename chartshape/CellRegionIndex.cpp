@@ -0,0 +1,279 @@
+/* This file is part of the KDE project
+
+   Copyright 2026 agent <agent@local>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+// Own
+#include "CellRegionIndex.h"
+
+// C
+#include <cmath>
+
+// Qt
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include <QRect>
+#include <QtAlgorithms>
+
+
+// Maximum number of children of a node in the R-tree
+static const int NodeCapacity = 8;
+
+namespace {
+
+struct Item {
+    QRect rect;
+    CellRegionIndex::Entry entry;
+};
+
+struct Node {
+    QRect bounds;
+    // Range of children in the next lower level, or of items for leaves
+    int first;
+    int count;
+};
+
+inline QRect boundsOf(const Item &item) { return item.rect; }
+inline QRect boundsOf(const Node &node) { return node.bounds; }
+
+template<typename T>
+bool centerXLessThan(const T &a, const T &b)
+{
+    return boundsOf(a).center().x() < boundsOf(b).center().x();
+}
+
+template<typename T>
+bool centerYLessThan(const T &a, const T &b)
+{
+    return boundsOf(a).center().y() < boundsOf(b).center().y();
+}
+
+/**
+ * Sorts @a elements into vertical slices of tiles (sort-tile-recursive)
+ * and groups every NodeCapacity consecutive elements into one node.
+ */
+template<typename T>
+QVector<Node> packLevel(QVector<T> &elements)
+{
+    const int count = elements.count();
+    const int nodeCount = (count + NodeCapacity - 1) / NodeCapacity;
+    const int sliceCount = (int)std::ceil(std::sqrt((double)nodeCount));
+    const int sliceSize = sliceCount * NodeCapacity;
+
+    qSort(elements.begin(), elements.end(), centerXLessThan<T>);
+    for (int i = 0; i < count; i += sliceSize)
+        qSort(elements.begin() + i, elements.begin() + qMin(i + sliceSize, count),
+              centerYLessThan<T>);
+
+    QVector<Node> nodes;
+    nodes.reserve(nodeCount);
+    for (int i = 0; i < count; i += NodeCapacity) {
+        Node node;
+        node.first = i;
+        node.count = qMin(NodeCapacity, count - i);
+        for (int j = node.first; j < node.first + node.count; j++)
+            node.bounds |= boundsOf(elements[j]);
+        nodes.append(node);
+    }
+
+    return nodes;
+}
+
+class TableIndex
+{
+public:
+    TableIndex() : dirty(true) {}
+
+    void build(const QVector<Item> &newItems);
+    void query(int level, int first, int count, const QRect &rect,
+               QSet<CellRegionIndex::Entry> *result) const;
+    void query(const QRect &rect, QSet<CellRegionIndex::Entry> *result) const;
+
+    bool dirty;
+    QVector<Item> items;
+    // levels[0] are the leaves, levels.last() the top level
+    QVector< QVector<Node> > levels;
+};
+
+void TableIndex::build(const QVector<Item> &newItems)
+{
+    items = newItems;
+    levels.clear();
+    dirty = false;
+
+    if (items.isEmpty())
+        return;
+
+    levels.append(packLevel(items));
+    while (levels.last().count() > NodeCapacity)
+        levels.append(packLevel(levels.last()));
+}
+
+void TableIndex::query(int level, int first, int count, const QRect &rect,
+                       QSet<CellRegionIndex::Entry> *result) const
+{
+    const QVector<Node> &nodes = levels[level];
+    for (int i = first; i < first + count; i++) {
+        const Node &node = nodes[i];
+        if (!node.bounds.intersects(rect))
+            continue;
+
+        if (level > 0) {
+            query(level - 1, node.first, node.count, rect, result);
+            continue;
+        }
+
+        for (int j = node.first; j < node.first + node.count; j++) {
+            if (items[j].rect.intersects(rect))
+                result->insert(items[j].entry);
+        }
+    }
+}
+
+void TableIndex::query(const QRect &rect, QSet<CellRegionIndex::Entry> *result) const
+{
+    if (levels.isEmpty())
+        return;
+    query(levels.count() - 1, 0, levels.last().count(), rect, result);
+}
+
+}
+
+
+class CellRegionIndex::Private
+{
+public:
+    Private();
+    ~Private();
+
+    void invalidate(const CellRegion &region);
+    const TableIndex &tableIndex(Table *table) const;
+
+    QHash<DataSet*, QMap<int, CellRegion> > regions;
+
+    // Built lazily, thus mutable
+    mutable QHash<Table*, TableIndex> tables;
+};
+
+CellRegionIndex::Private::Private()
+{
+}
+
+CellRegionIndex::Private::~Private()
+{
+}
+
+void CellRegionIndex::Private::invalidate(const CellRegion &region)
+{
+    tables[region.table()].dirty = true;
+}
+
+const TableIndex &CellRegionIndex::Private::tableIndex(Table *table) const
+{
+    TableIndex &index = tables[table];
+    if (!index.dirty)
+        return index;
+
+    QVector<Item> items;
+    QHash<DataSet*, QMap<int, CellRegion> >::const_iterator it;
+    for (it = regions.constBegin(); it != regions.constEnd(); ++it) {
+        QMap<int, CellRegion>::const_iterator regionIt;
+        for (regionIt = it->constBegin(); regionIt != it->constEnd(); ++regionIt) {
+            if (regionIt->table() != table)
+                continue;
+            Item item;
+            item.entry = Entry(it.key(), regionIt.key());
+            foreach (const QRect &rect, regionIt->rects()) {
+                if (!rect.isValid())
+                    continue;
+                item.rect = rect;
+                items.append(item);
+            }
+        }
+    }
+
+    index.build(items);
+    return index;
+}
+
+
+// ================================================================
+//                     Class CellRegionIndex
+
+
+CellRegionIndex::CellRegionIndex()
+    : d(new Private())
+{
+}
+
+CellRegionIndex::~CellRegionIndex()
+{
+    delete d;
+}
+
+void CellRegionIndex::setRegion(DataSet *dataSet, int role, const CellRegion &region)
+{
+    QMap<int, CellRegion> &dataSetRegions = d->regions[dataSet];
+    if (dataSetRegions.contains(role))
+        d->invalidate(dataSetRegions.take(role));
+
+    if (region.rectCount() > 0) {
+        dataSetRegions.insert(role, region);
+        d->invalidate(region);
+    }
+}
+
+void CellRegionIndex::remove(DataSet *dataSet)
+{
+    foreach (const CellRegion &region, d->regions.take(dataSet))
+        d->invalidate(region);
+}
+
+void CellRegionIndex::clear()
+{
+    d->regions.clear();
+    d->tables.clear();
+}
+
+QList<CellRegionIndex::Entry> CellRegionIndex::intersecting(const CellRegion &region) const
+{
+    QSet<Entry> result;
+
+    // Regions without a table intersect with regions in any table and
+    // vice versa, see CellRegion::intersects()
+    QList<Table*> tables;
+    if (region.table()) {
+        tables.append(region.table());
+        tables.append(0);
+    } else {
+        tables = d->tables.keys();
+    }
+
+    foreach (Table *table, tables) {
+        if (!d->tables.contains(table))
+            continue;
+        const TableIndex &index = d->tableIndex(table);
+        foreach (const QRect &rect, region.rects())
+            index.query(rect, &result);
+    }
+
+    return result.toList();
+}
@@ -0,0 +1,85 @@
+/* This file is part of the KDE project
+
+   Copyright 2026 agent <agent@local>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KCHART_CELLREGIONINDEX_H
+#define KCHART_CELLREGIONINDEX_H
+
+// Qt
+#include <QList>
+#include <QPair>
+
+// KChart
+#include "ChartShape.h"
+#include "CellRegion.h"
+
+
+/**
+ * @brief A spatial index mapping table cells to the data sets using them.
+ *
+ * Every data set has a number of cell regions (see DataSet), each of
+ * which is registered here under a role chosen by the user of this class.
+ * intersecting() then returns all (data set, role) pairs whose region
+ * intersects a given region, e.g. the cells that just changed in a table.
+ *
+ * The rectangles of all regions in a table are bulk-loaded into an R-tree
+ * (sort-tile-recursive packing) the first time that table is queried
+ * after one of its regions changed, so that a query costs O(log n + hits)
+ * instead of testing each region of each data set.
+ */
+class CHARTSHAPE_TEST_EXPORT CellRegionIndex
+{
+public:
+    typedef QPair<DataSet*, int> Entry;
+
+    CellRegionIndex();
+    ~CellRegionIndex();
+
+    /**
+     * Sets the region that @a dataSet uses for @a role, replacing any
+     * region previously set for this pair. A region without any rectangles
+     * removes it.
+     */
+    void setRegion(DataSet *dataSet, int role, const CellRegion &region);
+
+    /**
+     * Removes all regions of @a dataSet from the index.
+     */
+    void remove(DataSet *dataSet);
+
+    /**
+     * Removes all regions from the index.
+     */
+    void clear();
+
+    /**
+     * Returns all (data set, role) pairs whose region intersects
+     * @a region. Each pair is contained at most once.
+     *
+     * Like CellRegion::intersects(), regions without a table are
+     * considered to lie in any table.
+     */
+    QList<Entry> intersecting(const CellRegion &region) const;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+#endif // KCHART_CELLREGIONINDEX_H
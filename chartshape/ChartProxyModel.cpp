@@ -26,6 +26,9 @@
 // Qt
 #include <QRegion>
 #include <QPoint>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
 
 // KDE
 #include <KDebug>
@@ -46,6 +49,8 @@
 #include "Axis.h"
 #include "DataSet.h"
 #include "TableSource.h"
+#include "CellRegionIndex.h"
+#include "KDChartModel.h"
 #include "OdfLoadingHelper.h"
 
 
@@ -80,11 +85,47 @@ public:
 
     CellRegion       selection;
 
+    /// Maps the cells of all tables to the data sets in dataSets that
+    /// use them, see dataChanged()
+    CellRegionIndex  regionIndex;
+
+    // Batched changes, see beginUpdate()
+    int updateDepth;
+    int pendingChangeCount;
+    int suppressedSignalCount;
+    /// Changed cells per table since beginUpdate()
+    QHash<Table*, CellRegion> pendingChanges;
+    /// The KDChartModel's put into update mode by beginUpdate()
+    QList< QPointer<KDChartModel> > updatingModels;
+
+    /**
+     * Tells all data sets that use any of the cells in @a changedRegions
+     * that their data changed, each of them only once per role.
+     */
+    void notifyDataSets(const QList<CellRegion> &changedRegions);
+
+    /**
+     * Notifies the data sets about the changes collected since
+     * beginUpdate().
+     */
+    void flushPendingChanges();
+
     /**
      * Discards old and creates new data sets from the current region selection.
      */
     void rebuildDataMap();
 
+    /**
+     * Makes the data set notify us about changes to its regions and adds
+     * them to regionIndex. Must be called for every data set in dataSets.
+     */
+    void attachDataSet(DataSet *dataSet);
+
+    /**
+     * Reverts attachDataSet() for all data sets in dataSets.
+     */
+    void detachDataSets();
+
     /**
      * Extracts a list of data sets (with x data region, y data region, etc.
      * assigned) from the current d->selection.
@@ -97,12 +138,29 @@ public:
      */
     QList<DataSet*> createDataSetsFromRegion(QList<DataSet*> *dataSetsToRecycle,
                                               bool overrideCategories = true);
+
+    /**
+     * Adapts the selection and the regions of all data sets to rows
+     * (@a direction is Qt::Vertical) or columns (Qt::Horizontal) @a start
+     * to @a end being inserted into or removed from @a table, without
+     * re-creating the data sets.
+     *
+     * This is only possible if the lines run along the data sets, i.e. only
+     * data points are added or removed, and no label lines are affected.
+     *
+     * @return false if the change can't be applied incrementally
+     */
+    bool updateLines(Table *table, Qt::Orientation direction, bool inserted,
+                     int start, int end);
 };
 
 ChartProxyModel::Private::Private(ChartProxyModel *parent, TableSource *source)
     : q(parent)
     , tableSource(source)
     , isLoading(false)
+    , updateDepth(0)
+    , pendingChangeCount(0)
+    , suppressedSignalCount(0)
 {
     firstRowIsLabel    = false;
     firstColumnIsLabel = false;
@@ -118,6 +176,8 @@ ChartProxyModel::Private::Private(ChartProxyModel *parent, TableSource *source)
 
 ChartProxyModel::Private::~Private()
 {
+    // No need for the data sets to tell us that they are gone
+    detachDataSets();
     qDeleteAll(dataSets);
     qDeleteAll(removedDataSets);
 }
@@ -161,10 +221,31 @@ void ChartProxyModel::Private::rebuildDataMap()
     // set by "somebody" else in the meantime.
     // if (isLoading)
     //     return;
+    q->beginUpdate();
     q->beginResetModel();
     q->invalidateDataSets();
     dataSets = createDataSetsFromRegion(&removedDataSets);
+    foreach (DataSet *dataSet, dataSets)
+        attachDataSet(dataSet);
     q->endResetModel();
+    q->endUpdate();
+}
+
+void ChartProxyModel::Private::attachDataSet(DataSet *dataSet)
+{
+    dataSet->setProxyModel(q);
+    regionIndex.setRegion(dataSet, XDataRole, dataSet->xDataRegion());
+    regionIndex.setRegion(dataSet, YDataRole, dataSet->yDataRegion());
+    regionIndex.setRegion(dataSet, CustomDataRole, dataSet->customDataRegion());
+    regionIndex.setRegion(dataSet, LabelDataRole, dataSet->labelDataRegion());
+    regionIndex.setRegion(dataSet, CategoryDataRole, dataSet->categoryDataRegion());
+}
+
+void ChartProxyModel::Private::detachDataSets()
+{
+    foreach (DataSet *dataSet, dataSets)
+        dataSet->setProxyModel(0);
+    regionIndex.clear();
 }
 
 void ChartProxyModel::addTable(Table *table)
@@ -236,6 +317,123 @@ static CellRegion extractColumn(const CellRegion &region, int col, int rowOffset
     return result;
 }
 
+static QRect transposed(const QRect &rect)
+{
+    return QRect(rect.y(), rect.x(), rect.height(), rect.width());
+}
+
+/**
+ * Returns @a region with @a count lines inserted before line @a first.
+ * Lines are rows if @a direction is Qt::Vertical, columns otherwise.
+ *
+ * Rectangles that span @a first grow, rectangles behind it move. Lines
+ * appended right after @a lastLine extend the rectangles ending there.
+ */
+static CellRegion insertLines(const CellRegion &region, Qt::Orientation direction,
+                              int first, int count, int lastLine)
+{
+    CellRegion result(region.table());
+    foreach (const QRect &rect, region.rects()) {
+        QRect r = direction == Qt::Vertical ? rect : transposed(rect);
+        if (r.top() >= first)
+            r.translate(0, count);
+        else if (first <= r.bottom() || (first == lastLine + 1 && r.bottom() == lastLine))
+            r.setBottom(r.bottom() + count);
+        result.add(direction == Qt::Vertical ? r : transposed(r));
+    }
+
+    return result;
+}
+
+/**
+ * Returns @a region with lines @a first to @a last removed, see
+ * insertLines().
+ */
+static CellRegion removeLines(const CellRegion &region, Qt::Orientation direction,
+                              int first, int last)
+{
+    CellRegion result(region.table());
+    foreach (const QRect &rect, region.rects()) {
+        QRect r = direction == Qt::Vertical ? rect : transposed(rect);
+        const int removedBefore = qMax(0, qMin(last, r.top() - 1) - first + 1);
+        const int removedInside = qMax(0, qMin(last, r.bottom()) - qMax(first, r.top()) + 1);
+        r.translate(0, -removedBefore);
+        r.setHeight(r.height() - removedInside);
+        if (r.height() > 0)
+            result.add(direction == Qt::Vertical ? r : transposed(r));
+    }
+
+    return result;
+}
+
+/**
+ * Returns @a region with lines @a first to @a last inserted or removed if
+ * it lies in @a table, and @a region unchanged otherwise.
+ */
+static CellRegion changeLines(const CellRegion &region, Table *table, Qt::Orientation direction,
+                              bool inserted, int first, int last, int lastLine)
+{
+    if (region.table() != table || region.rectCount() == 0)
+        return region;
+    if (inserted)
+        return insertLines(region, direction, first, last - first + 1, lastLine);
+    return removeLines(region, direction, first, last);
+}
+
+bool ChartProxyModel::Private::updateLines(Table *table, Qt::Orientation direction,
+                                           bool inserted, int start, int end)
+{
+    // Anything else changes the number of data sets or their labels
+    if (isLoading || direction != dataDirection ||
+        selection.table() != table || selection.rectCount() != 1)
+        return false;
+
+    const QRect selectionRect = direction == Qt::Vertical ? selection.rects().first()
+                                                          : transposed(selection.rects().first());
+    const bool hasLabelLine = direction == Qt::Vertical ? firstRowIsLabel : firstColumnIsLabel;
+    const int firstDataLine = selectionRect.top() + (hasLabelLine ? 1 : 0);
+    const int lastLine = selectionRect.bottom();
+    // The top-left cell is (1,1), see CellRegion
+    const int first = start + 1;
+    const int last = end + 1;
+
+    if (lastLine < firstDataLine)
+        return false;
+    if (inserted) {
+        if (first < firstDataLine || first > lastLine + 1)
+            return false;
+        // Below a label line, the selection would grow by a line none of
+        // the data sets contains. Without one, all regions move down.
+        if (hasLabelLine && first == firstDataLine)
+            return false;
+    } else {
+        if (first < firstDataLine || last > lastLine || last - first >= lastLine - firstDataLine)
+            return false;
+    }
+
+    // Regions of other tables are not affected, see changeLines()
+    selection = changeLines(selection, table, direction, inserted, first, last, lastLine);
+    categoryDataRegion = changeLines(categoryDataRegion, table, direction, inserted, first, last, lastLine);
+
+    // Let the KDChartModel's merge the changes of all regions
+    q->beginUpdate();
+
+    // The size of a data set only changes once, with the first region
+    // set here that grows or shrinks.
+    foreach (DataSet *dataSet, dataSets) {
+        dataSet->setCategoryDataRegion(changeLines(dataSet->categoryDataRegion(), table, direction, inserted, first, last, lastLine));
+        dataSet->setXDataRegion(changeLines(dataSet->xDataRegion(), table, direction, inserted, first, last, lastLine));
+        dataSet->setYDataRegion(changeLines(dataSet->yDataRegion(), table, direction, inserted, first, last, lastLine));
+        dataSet->setCustomDataRegion(changeLines(dataSet->customDataRegion(), table, direction, inserted, first, last, lastLine));
+        dataSet->setLabelDataRegion(changeLines(dataSet->labelDataRegion(), table, direction, inserted, first, last, lastLine));
+    }
+
+    q->endUpdate();
+
+    emit q->dataChanged();
+    return true;
+}
+
 QList<DataSet*> ChartProxyModel::Private::createDataSetsFromRegion(QList<DataSet*> *dataSetsToRecycle,
                                                                     bool overrideCategories)
 {
@@ -398,6 +596,8 @@ bool ChartProxyModel::loadOdf(const KXmlElement &element,
     bool ignoreCellRanges = helper->chartUsesInternalModelOnly;
 #endif
 
+    // Loading sets many properties of each data set
+    beginUpdate();
     beginResetModel();
 
     if (element.hasAttributeNS(KOdfXmlNS::chart, "style-name")) {
@@ -453,6 +653,7 @@ bool ChartProxyModel::loadOdf(const KXmlElement &element,
 
     // For every data set, there must be an explicit <chart:series> element,
     // which we will load later.
+    d->detachDataSets();
     d->dataSets.clear();
     d->removedDataSets.clear();
 
@@ -505,6 +706,7 @@ bool ChartProxyModel::loadOdf(const KXmlElement &element,
                 dataSet = new DataSet(d->dataSets.size());
             }
             d->dataSets.append(dataSet);
+            d->attachDataSet(dataSet);
             if (d->categoryDataRegion.isValid())
             {
                 dataSet->setCategoryDataRegion(d->categoryDataRegion);
@@ -560,6 +762,7 @@ bool ChartProxyModel::loadOdf(const KXmlElement &element,
 
     //rebuildDataMap();
     endResetModel();
+    endUpdate();
 
     return true;
 }
@@ -589,26 +792,81 @@ void ChartProxyModel::dataChanged(const QModelIndex& topLeft, const QModelIndex&
     // Precisely determine what data in what table changed so that we don't
     // do unnecessary, expensive updates.
     Table *table = d->tableSource->get(topLeft.model());
-    CellRegion dataChangedRegion(table, dataChangedRect);
 
-    foreach (DataSet *dataSet, d->dataSets) {
-        if (dataSet->xDataRegion().intersects(dataChangedRegion))
-            dataSet->xDataChanged(QRect());
+    if (d->updateDepth > 0) {
+        QHash<Table*, CellRegion>::iterator it = d->pendingChanges.find(table);
+        if (it == d->pendingChanges.end())
+            d->pendingChanges.insert(table, CellRegion(table, dataChangedRect));
+        else
+            it->add(dataChangedRect);
+        d->pendingChangeCount++;
+        return;
+    }
 
-        if (dataSet->yDataRegion().intersects(dataChangedRegion))
-            dataSet->yDataChanged(QRect());
+    d->notifyDataSets(QList<CellRegion>() << CellRegion(table, dataChangedRect));
 
-        if (dataSet->categoryDataRegion().intersects(dataChangedRegion))
-            dataSet->categoryDataChanged(QRect());
+    emit dataChanged();
+}
 
-        if (dataSet->labelDataRegion().intersects(dataChangedRegion))
-            dataSet->labelDataChanged(QRect());
+void ChartProxyModel::Private::notifyDataSets(const QList<CellRegion> &changedRegions)
+{
+    // The changed cells per data set and role
+    QHash<CellRegionIndex::Entry, QRect> entries;
+    foreach (const CellRegion &region, changedRegions) {
+        const QRect changedRect = region.boundingRect();
+        foreach (const CellRegionIndex::Entry &entry, regionIndex.intersecting(region))
+            entries[entry] |= changedRect;
+    }
 
-        if (dataSet->customDataRegion().intersects(dataChangedRegion))
-            dataSet->customDataChanged(QRect());
+    // Let the KDChartModel's merge what they emit for the same data set
+    QSet<KDChartModel*> models;
+    foreach (const CellRegionIndex::Entry &entry, entries.keys()) {
+        if (entry.first->kdChartModel())
+            models.insert(entry.first->kdChartModel());
+    }
+    foreach (KDChartModel *model, models)
+        model->beginUpdate();
+
+    // Only visit the data sets that actually use any of the changed cells
+    QHash<CellRegionIndex::Entry, QRect>::const_iterator it;
+    for (it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        DataSet *dataSet = it.key().first;
+        const QRect &changedRect = it.value();
+        switch (it.key().second) {
+        case XDataRole:
+            dataSet->xDataChanged(changedRect);
+            break;
+        case YDataRole:
+            dataSet->yDataChanged(changedRect);
+            break;
+        case CategoryDataRole:
+            dataSet->categoryDataChanged(changedRect);
+            break;
+        case LabelDataRole:
+            dataSet->labelDataChanged(changedRect);
+            break;
+        case CustomDataRole:
+            dataSet->customDataChanged(changedRect);
+            break;
+        }
     }
 
-    emit dataChanged();
+    foreach (KDChartModel *model, models)
+        model->endUpdate();
+}
+
+void ChartProxyModel::Private::flushPendingChanges()
+{
+    if (pendingChanges.isEmpty())
+        return;
+
+    const QList<CellRegion> changedRegions = pendingChanges.values();
+    pendingChanges.clear();
+    notifyDataSets(changedRegions);
+
+    suppressedSignalCount += pendingChangeCount - 1;
+    pendingChangeCount = 0;
+    emit q->dataChanged();
 }
 
 
@@ -669,6 +927,7 @@ Qt::Orientation ChartProxyModel::dataDirection()
 
 void ChartProxyModel::invalidateDataSets()
 {
+    d->detachDataSets();
     d->removedDataSets = d->dataSets;
     d->dataSets.clear();
 }
@@ -693,6 +952,72 @@ void ChartProxyModel::endLoading()
     // d->rebuildDataMap();
 }
 
+bool ChartProxyModel::tableRowsInserted(Table *table, int start, int end)
+{
+    return d->updateLines(table, Qt::Vertical, true, start, end);
+}
+
+bool ChartProxyModel::tableColumnsInserted(Table *table, int start, int end)
+{
+    return d->updateLines(table, Qt::Horizontal, true, start, end);
+}
+
+bool ChartProxyModel::tableRowsRemoved(Table *table, int start, int end)
+{
+    return d->updateLines(table, Qt::Vertical, false, start, end);
+}
+
+bool ChartProxyModel::tableColumnsRemoved(Table *table, int start, int end)
+{
+    return d->updateLines(table, Qt::Horizontal, false, start, end);
+}
+
+void ChartProxyModel::beginUpdate()
+{
+    if (d->updateDepth++ > 0)
+        return;
+
+    // The data sets' models merge what they emit until endUpdate(), too.
+    // Data sets that were just removed may be recycled in the meantime.
+    QSet<KDChartModel*> models;
+    foreach (DataSet *dataSet, d->dataSets + d->removedDataSets) {
+        if (dataSet->kdChartModel())
+            models.insert(dataSet->kdChartModel());
+    }
+    foreach (KDChartModel *model, models) {
+        model->beginUpdate();
+        d->updatingModels.append(model);
+    }
+}
+
+void ChartProxyModel::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (d->updateDepth <= 0)
+        return;
+
+    if (--d->updateDepth > 0)
+        return;
+
+    d->flushPendingChanges();
+    const QList< QPointer<KDChartModel> > models = d->updatingModels;
+    d->updatingModels.clear();
+    foreach (KDChartModel *model, models) {
+        if (model)
+            model->endUpdate();
+    }
+}
+
+bool ChartProxyModel::isUpdating() const
+{
+    return d->updateDepth > 0;
+}
+
+int ChartProxyModel::suppressedSignalCount() const
+{
+    return d->suppressedSignalCount;
+}
+
 void ChartProxyModel::setDataDirection(Qt::Orientation orientation)
 {
     if (d->dataDirection == orientation)
@@ -736,4 +1061,33 @@ QList<DataSet*> ChartProxyModel::dataSets() const
     return d->dataSets;
 }
 
+void ChartProxyModel::dataSetRegionChanged(DataSet *dataSet, DataRole role)
+{
+    CellRegion region;
+    switch (role) {
+    case XDataRole:
+        region = dataSet->xDataRegion();
+        break;
+    case YDataRole:
+        region = dataSet->yDataRegion();
+        break;
+    case CustomDataRole:
+        region = dataSet->customDataRegion();
+        break;
+    case LabelDataRole:
+        region = dataSet->labelDataRegion();
+        break;
+    case CategoryDataRole:
+        region = dataSet->categoryDataRegion();
+        break;
+    }
+
+    d->regionIndex.setRegion(dataSet, role, region);
+}
+
+void ChartProxyModel::dataSetDestroyed(DataSet *dataSet)
+{
+    d->regionIndex.remove(dataSet);
+}
+
 #include "ChartProxyModel.moc"
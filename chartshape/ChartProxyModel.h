@@ -157,6 +157,18 @@ public:
      */
     QList<DataSet*> dataSets() const;
 
+    /**
+     * Called by DataSet whenever the cell region it uses for @a role
+     * changes, so that changes in that region are routed to it.
+     */
+    void dataSetRegionChanged(DataSet *dataSet, DataRole role);
+
+    /**
+     * Called by DataSet when it is deleted, so that changes in its former
+     * regions aren't routed to it anymore.
+     */
+    void dataSetDestroyed(DataSet *dataSet);
+
     /**
      * Clears the list of data sets, but keeps them in a list of "removed"
      * data sets for the next time that reset() is called. The latter list
@@ -183,6 +195,43 @@ public:
      */
     void endLoading();
 
+    /**
+     * Called by SingleModelHelper when rows or columns @a start to @a end
+     * have been inserted into or removed from @a table.
+     *
+     * If only data points are added or removed by this, the cell regions
+     * of the existing data sets are extended or shrunk in place.
+     *
+     * @return false if the change affects the number of data sets or their
+     * labels. The caller has to reset() the model in that case.
+     */
+    bool tableRowsInserted(Table *table, int start, int end);
+    bool tableColumnsInserted(Table *table, int start, int end);
+    bool tableRowsRemoved(Table *table, int start, int end);
+    bool tableColumnsRemoved(Table *table, int start, int end);
+
+    /**
+     * Starts a batch of changes in the source tables, e.g. a
+     * recalculation changing many cells one by one.
+     *
+     * Until the matching endUpdate(), changed cells are only collected.
+     * endUpdate() then notifies each affected data set only once, and the
+     * KDChartModel's of the data sets emit one merged signal per data set.
+     * Calls can be nested.
+     *
+     * Rebuilding the data sets, loading them and moving their regions for
+     * inserted or removed lines are batched like this, too.
+     */
+    void beginUpdate();
+    void endUpdate();
+    bool isUpdating() const;
+
+    /**
+     * The total number of dataChanged() signals that were not emitted
+     * because they were merged in between beginUpdate() and endUpdate().
+     */
+    int suppressedSignalCount() const;
+
 public slots:
     /**
      * Connected to dataChanged() signal of source models in TableSource.
@@ -28,6 +28,7 @@
 
 // Qt
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QString>
 #include <QPen>
 #include <QColor>
@@ -47,7 +48,9 @@
 
 // KChart
 #include "Axis.h"
+#include "ChartProxyModel.h"
 #include "PlotArea.h"
+#include "RingBuffer.h"
 #include "Surface.h"
 #include "OdfLoadingHelper.h"
 
@@ -88,6 +91,35 @@ public:
     ChartType    effectiveChartType() const;
     bool         isValidDataPoint(const QPoint &point) const;
     QVariant     data(const CellRegion &region, int index) const;
+    QVariant     cellData(QAbstractItemModel *model, const QPoint &dataPoint) const;
+    QAbstractItemModel *sourceModel(const CellRegion &region) const;
+
+    /**
+     * Reads the values of the data points [first, first + count) in
+     * @a region into @a out, walking the region only once.
+     *
+     * Values that are not numbers, e.g. empty cells or points beyond the
+     * end of the region, are set to 0 and marked 0 in @a validMask.
+     *
+     * @return The number of valid values
+     */
+    int fetch(const CellRegion &region, int first, int count,
+              double *out, quint8 *validMask) const;
+
+    /**
+     * Same as fetch(), but reads the cells as they are, i.e. what data()
+     * returns for each of the data points.
+     */
+    void fetchCells(const CellRegion &region, int first, int count, QVariant *out) const;
+
+    /// Same as fetch(), but from one of the buffers of streaming mode
+    int fetchStreamed(const RingBuffer<double> &buffer, int first, int count,
+                      double *out, quint8 *validMask) const;
+
+    /// The label of category @a index if there's no cell for it
+    QString defaultCategoryLabel(int index) const;
+
+    bool isStreaming() const { return streamYValues.capacity() > 0; }
 
     QBrush defaultBrush() const;
     QBrush defaultBrush(int section) const;
@@ -101,6 +133,18 @@ public:
     /// have its own DataValueAttributes copy yet.
     void insertDataValueAttributeSectionIfNecessary(int section);
 
+    /// Computes what DataSet::dataValueAttributes() returns, uncached.
+    KDChart::DataValueAttributes resolveDataValueAttributes(int section) const;
+    /// Returns true if @a section resolves to other attributes than the
+    /// data set itself, i.e. it has its own pen, brush or attributes, or
+    /// is drawn with its own default brush.
+    bool hasSectionAttributes(int section) const;
+    /// Drops the cached attributes of @a section, or all of them if -1.
+    void invalidateAttributeCache(int section = -1);
+    /// Drops all cached attributes if the chart type or the data
+    /// direction changed since they were cached.
+    void validateAttributeCache() const;
+
     /**
      * FIXME: Refactor (post-2.3)
      *        1) Maximum bubble width should be determined in ChartProxyModel
@@ -155,6 +199,15 @@ public:
     QMap<int, KDChart::DataValueAttributes> sectionsDataValueAttributes;
     QMap<int, bool> sectionsShowLabels;
 
+    // Resolved data value attributes, see DataSet::dataValueAttributes().
+    // All sections without own attributes share defaultAttributesCache.
+    mutable QHash<int, KDChart::DataValueAttributes> sectionAttributesCache;
+    mutable KDChart::DataValueAttributes defaultAttributesCache;
+    mutable bool defaultAttributesCached;
+    // What the cached attributes depend on outside of this data set
+    mutable ChartType cachedChartType;
+    mutable Qt::Orientation cachedDataDirection;
+
     /// The number of this series is passed in the constructor and after
     /// that never changes.
     const int num;
@@ -170,6 +223,13 @@ public:
     CellRegion categoryDataRegion; // x labels -- same for all datasets
 
     KDChartModel *kdChartModel;
+    ChartProxyModel *proxyModel;
+
+    // Streaming mode, see DataSet::setStreamingCapacity()
+    RingBuffer<double> streamXValues;
+    RingBuffer<double> streamYValues;
+    // Number of data points ever appended
+    qint64 streamedCount;
 
     int size;
 
@@ -197,8 +257,13 @@ DataSet::Private::Private(DataSet *parent, int dataSetNr) :
     pen(QPen(Qt::black)),
     brush(QColor(Qt::white)),    
     dataValueAttributes(defaultDataValueAttributes()),
+    defaultAttributesCached(false),
+    cachedChartType(LastChartType),
+    cachedDataDirection(Qt::Vertical),
     num(dataSetNr),
     kdChartModel(0),
+    proxyModel(0),
+    streamedCount(0),
     size(0),
     defaultLabel(i18n("Series %1", dataSetNr + 1)),
     symbolsActivated(true),
@@ -265,13 +330,50 @@ void DataSet::Private::insertDataValueAttributeSectionIfNecessary(int section)
         sectionsDataValueAttributes[ section ] = dataValueAttributes;
 }
 
+bool DataSet::Private::hasSectionAttributes(int section) const
+{
+    if (pens.contains(section) || brushes.contains(section) ||
+        sectionsDataValueAttributes.contains(section))
+        return true;
+    // See defaultBrush(int)
+    return !brushIsSet && kdChartModel && kdChartModel->dataDirection() == Qt::Horizontal;
+}
+
+void DataSet::Private::invalidateAttributeCache(int section /* = -1 */)
+{
+    if (section >= 0) {
+        sectionAttributesCache.remove(section);
+        return;
+    }
+    sectionAttributesCache.clear();
+    defaultAttributesCached = false;
+}
+
+void DataSet::Private::validateAttributeCache() const
+{
+    const ChartType chartType = effectiveChartType();
+    const Qt::Orientation dataDirection = kdChartModel ? kdChartModel->dataDirection() : Qt::Vertical;
+    if (chartType == cachedChartType && dataDirection == cachedDataDirection)
+        return;
+
+    sectionAttributesCache.clear();
+    defaultAttributesCached = false;
+    cachedChartType = chartType;
+    cachedDataDirection = dataDirection;
+}
+
 void DataSet::Private::updateSize()
 {
     int newSize = 0;
-    newSize = qMax(newSize, xDataRegion.cellCount());
-    newSize = qMax(newSize, yDataRegion.cellCount());
-    newSize = qMax(newSize, customDataRegion.cellCount());
-    newSize = qMax(newSize, categoryDataRegion.cellCount());
+    if (isStreaming()) {
+        // The cell regions don't matter as long as data is streamed
+        newSize = streamYValues.count();
+    } else {
+        newSize = qMax(newSize, xDataRegion.cellCount());
+        newSize = qMax(newSize, yDataRegion.cellCount());
+        newSize = qMax(newSize, customDataRegion.cellCount());
+        newSize = qMax(newSize, categoryDataRegion.cellCount());
+    }
 
     if (size != newSize) {
         size = newSize;
@@ -313,28 +415,39 @@ bool DataSet::Private::isValidDataPoint(const QPoint &point) const
     return true;
 }
 
-QVariant DataSet::Private::data(const CellRegion &region, int index) const
+QAbstractItemModel *DataSet::Private::sourceModel(const CellRegion &region) const
 {
     if (!region.isValid())
-        return QVariant();
-    if (!region.hasPointAtIndex(index))
-        return QVariant();
-
-    // The result
-    QVariant data;
+        return 0;
 
-    // Convert the given index in this dataset to a data point in the
-    // source model.
-    QPoint dataPoint = region.pointAtIndex(index);
     Table *table = region.table();
     Q_ASSERT(table);
-    QAbstractItemModel *model = table->model();
-    // This means the table the region lies in has been removed, but nobody
-    // has changed the region in the meantime. That is a perfectly valid
-    // scenario, so just return invalid data.
+    // If this is 0, the table the region lies in has been removed, but
+    // nobody has changed the region in the meantime. That is a perfectly
+    // valid scenario, so just return invalid data.
+    return table->model();
+}
+
+QVariant DataSet::Private::data(const CellRegion &region, int index) const
+{
+    QAbstractItemModel *model = sourceModel(region);
     if (!model)
         return QVariant();
 
+    // Convert the given index in this dataset to a data point in the
+    // source model.
+    const QPoint dataPoint = region.pointAtIndex(index);
+    if (dataPoint == QPoint(-1, -1))
+        return QVariant();
+
+    return cellData(model, dataPoint);
+}
+
+QVariant DataSet::Private::cellData(QAbstractItemModel *model, const QPoint &dataPoint) const
+{
+    // The result
+    QVariant data;
+
     // FIXME: Why not use this immediately if true?
     const bool verticalHeaderData   = dataPoint.x() == 0;
     const bool horizontalHeaderData = dataPoint.y() == 0;
@@ -367,6 +480,81 @@ QVariant DataSet::Private::data(const CellRegion &region, int index) const
     return data;
 }
 
+int DataSet::Private::fetch(const CellRegion &region, int first, int count,
+                            double *out, quint8 *validMask) const
+{
+    Q_ASSERT(first >= 0);
+
+    for (int i = 0; i < count; i++) {
+        out[i] = 0.0;
+        if (validMask)
+            validMask[i] = 0;
+    }
+
+    QAbstractItemModel *model = sourceModel(region);
+    if (!model)
+        return 0;
+
+    int validCount = 0;
+    const CellRegion::const_iterator end = region.end();
+    CellRegion::const_iterator it = region.iteratorAt(first);
+    for (int i = 0; i < count && it != end; ++i, ++it) {
+        bool ok = false;
+        const double value = cellData(model, *it).toDouble(&ok);
+        if (!ok)
+            continue;
+        out[i] = value;
+        if (validMask)
+            validMask[i] = 1;
+        validCount++;
+    }
+
+    return validCount;
+}
+
+void DataSet::Private::fetchCells(const CellRegion &region, int first, int count, QVariant *out) const
+{
+    Q_ASSERT(first >= 0);
+
+    QAbstractItemModel *model = sourceModel(region);
+    const CellRegion::const_iterator end = region.end();
+    CellRegion::const_iterator it = region.iteratorAt(first);
+    for (int i = 0; i < count; i++) {
+        if (!model || it == end) {
+            out[i] = QVariant();
+            continue;
+        }
+        out[i] = cellData(model, *it);
+        ++it;
+    }
+}
+
+int DataSet::Private::fetchStreamed(const RingBuffer<double> &buffer, int first, int count,
+                                    double *out, quint8 *validMask) const
+{
+    Q_ASSERT(first >= 0);
+
+    const int validCount = qBound(0, buffer.count() - first, count);
+    if (validCount > 0)
+        buffer.copy(first, validCount, out);
+    for (int i = 0; i < count; i++) {
+        if (i >= validCount)
+            out[i] = 0.0;
+        if (validMask)
+            validMask[i] = i < validCount;
+    }
+
+    return validCount;
+}
+
+QString DataSet::Private::defaultCategoryLabel(int index) const
+{
+    // Streamed data points keep their number when older ones are dropped
+    if (isStreaming())
+        return QString::number(streamedCount - streamYValues.count() + index + 1);
+    return QString::number(index + 1);
+}
+
 QBrush DataSet::Private::defaultBrush() const
 {
     Qt::Orientation modelDataDirection = kdChartModel->dataDirection();
@@ -413,6 +601,8 @@ DataSet::~DataSet()
 {
     if (d->attachedAxis)
         d->attachedAxis->detachDataSet(this, true);
+    if (d->proxyModel)
+        d->proxyModel->dataSetDestroyed(this);
 
     delete d;
 }
@@ -588,10 +778,32 @@ qreal DataSet::Private::maxBubbleSize() const
 
 KDChart::DataValueAttributes DataSet::dataValueAttributes(int section /* = -1 */) const
 {
-    KDChart::DataValueAttributes attr(d->dataValueAttributes);
-    Q_ASSERT(attr.isVisible() == d->dataValueAttributes.isVisible());
-    if (d->sectionsDataValueAttributes.contains(section))
-        attr = d->sectionsDataValueAttributes[ section ];
+    // Bubble sizes depend on the data of all data sets, don't cache those
+    if (d->effectiveChartType() == BubbleChartType)
+        return d->resolveDataValueAttributes(section);
+
+    d->validateAttributeCache();
+
+    if (section < 0 || !d->hasSectionAttributes(section)) {
+        if (!d->defaultAttributesCached) {
+            d->defaultAttributesCache = d->resolveDataValueAttributes(-1);
+            d->defaultAttributesCached = true;
+        }
+        return d->defaultAttributesCache;
+    }
+
+    QHash<int, KDChart::DataValueAttributes>::const_iterator it = d->sectionAttributesCache.constFind(section);
+    if (it == d->sectionAttributesCache.constEnd())
+        it = d->sectionAttributesCache.insert(section, d->resolveDataValueAttributes(section));
+    return *it;
+}
+
+KDChart::DataValueAttributes DataSet::Private::resolveDataValueAttributes(int section) const
+{
+    KDChart::DataValueAttributes attr(dataValueAttributes);
+    Q_ASSERT(attr.isVisible() == dataValueAttributes.isVisible());
+    if (sectionsDataValueAttributes.contains(section))
+        attr = sectionsDataValueAttributes[ section ];
 
     /*
      * Update attributes that are related to properties out of the data
@@ -600,7 +812,7 @@ KDChart::DataValueAttributes DataSet::dataValueAttributes(int section /* = -1 */
     KDChart::MarkerAttributes ma(attr.markerAttributes());
 
     // The chart type is a property of the plot area, check that.
-    switch (d->effectiveChartType()) {
+    switch (effectiveChartType()) {
 //     case ScatterChartType:
 //         // TODO: Marker type should be customizable
 //         // TODO: Marker size should be customizable
@@ -609,13 +821,13 @@ KDChart::DataValueAttributes DataSet::dataValueAttributes(int section /* = -1 */
 //         break;
     case BubbleChartType:
     {
-        Q_ASSERT(attachedAxis());
-        Q_ASSERT(attachedAxis()->plotArea());
+        Q_ASSERT(attachedAxis);
+        Q_ASSERT(attachedAxis->plotArea());
         ma.setMarkerStyle(KDChart::MarkerAttributes::MarkerCircle);        
-        ma.setThreeD(attachedAxis()->plotArea()->isThreeD());
-        qreal maxSize = d->maxBubbleSize();
+        ma.setThreeD(attachedAxis->plotArea()->isThreeD());
+        qreal maxSize = maxBubbleSize();
         if (section >= 0) {
-            qreal bubbleWidth = customData(section).toReal();
+            qreal bubbleWidth = parent->customData(section).toReal();
             // All bubble sizes are relative to the maximum bubble size
             if (maxSize != 0.0)
                 bubbleWidth /= maxSize;
@@ -630,10 +842,10 @@ KDChart::DataValueAttributes DataSet::dataValueAttributes(int section /* = -1 */
     }
     default:
         // TODO: Make markers customizable even for other types
-        if (d->symbolsActivated)
+        if (symbolsActivated)
         {            
             Q_ASSERT(attr.isVisible());
-            ma.setMarkerStyle(defaultMarkerTypes[ d->symbolID ]);
+            ma.setMarkerStyle(defaultMarkerTypes[ symbolID ]);
             ma.setMarkerSize(QSize(10, 10));
             ma.setVisible(true);
 //             attr.setVisible(true);
@@ -645,8 +857,8 @@ KDChart::DataValueAttributes DataSet::dataValueAttributes(int section /* = -1 */
         break;
     }
 
-    ma.setMarkerColor(brush(section).color());
-    ma.setPen(pen(section));
+    ma.setMarkerColor(parent->brush(section).color());
+    ma.setPen(parent->pen(section));
     attr.setMarkerAttributes(ma);
 
     return attr;
@@ -656,6 +868,7 @@ void DataSet::setPen(const QPen &pen)
 {
     d->pen = pen;
     d->penIsSet = true;
+    d->invalidateAttributeCache();
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this);
 //     KDChart::MarkerAttributes ma(d->dataValueAttributes.markerAttributes());
@@ -674,6 +887,7 @@ void DataSet::setBrush(const QBrush &brush)
 {
     d->brush = brush;
     d->brushIsSet = true;
+    d->invalidateAttributeCache();
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this);
 //     KDChart::MarkerAttributes ma(d->dataValueAttributes.markerAttributes());
@@ -697,6 +911,7 @@ void DataSet::setPieExplodeFactor(int factor)
 void DataSet::setPen(int section, const QPen &pen)
 {
     d->pens[ section ] = pen;
+    d->invalidateAttributeCache(section);
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::PenDataRole, section);
     d->insertDataValueAttributeSectionIfNecessary(section);
@@ -708,6 +923,7 @@ void DataSet::setPen(int section, const QPen &pen)
 void DataSet::setBrush(int section, const QBrush &brush)
 {
     d->brushes[ section ] = brush;
+    d->invalidateAttributeCache(section);
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::BrushDataRole, section);
     d->insertDataValueAttributeSectionIfNecessary(section);
@@ -787,11 +1003,18 @@ void DataSet::setUpperErrorLimit(qreal limit)
 
 QVariant DataSet::xData(int index) const
 {
+    if (d->isStreaming()) {
+        if (index >= 0 && index < d->streamXValues.count())
+            return d->streamXValues.at(index);
+        return QVariant(index + 1);
+    }
+
     // Sometimes a bubble chart is created with a table with 4 columns.
     // What we do here is assign the 2 columns per data set, so we have
     // 2 data sets in total afterwards. The first column is y data, the second
     // bubble width. Same for the second data set. So there is nothing left
     // for x data. Instead use a fall-back to the data points index.
+
     QVariant data = d->data(d->xDataRegion, index);
     if (data.isValid() && data.canConvert< double >() && data.convert(QVariant::Double))
         return data;
@@ -803,6 +1026,12 @@ QVariant DataSet::yData(int index) const
     // No fall-back necessary. y data region must be specified if needed.
     // (may also be part of 'domain' in ODF terms, but only in case of
     // scatter and bubble charts)
+    if (d->isStreaming()) {
+        if (index >= 0 && index < d->streamYValues.count())
+            return d->streamYValues.at(index);
+        return QVariant();
+    }
+
     return d->data(d->yDataRegion, index);
 }
 
@@ -818,9 +1047,10 @@ QVariant DataSet::customData(int index) const
 QVariant DataSet::categoryData(int index) const
 {
     // There's no cell that holds this category's data
-    // (i.e., the region is either too short or simply empty)
-    if (!d->categoryDataRegion.hasPointAtIndex(index))
-        return QString::number(index + 1);
+    // (i.e., the region is either too short or simply empty), or the
+    // data points are streamed and don't belong to any cell
+    if (d->isStreaming() || !d->categoryDataRegion.hasPointAtIndex(index))
+        return d->defaultCategoryLabel(index);
 
     const QVariant data = d->data(d->categoryDataRegion, index);
     // The cell contains valid data
@@ -830,6 +1060,147 @@ QVariant DataSet::categoryData(int index) const
     return QString("");
 }
 
+int DataSet::fetchXData(int first, int count, double *out, quint8 *validMask) const
+{
+    QVector<quint8> mask(count);
+    if (d->isStreaming())
+        d->fetchStreamed(d->streamXValues, first, count, out, mask.data());
+    else
+        d->fetch(d->xDataRegion, first, count, out, mask.data());
+
+    // Same fall-back as in xData()
+    for (int i = 0; i < count; i++) {
+        if (!mask[i])
+            out[i] = first + i + 1;
+        if (validMask)
+            validMask[i] = 1;
+    }
+
+    return count;
+}
+
+int DataSet::fetchYData(int first, int count, double *out, quint8 *validMask) const
+{
+    if (d->isStreaming())
+        return d->fetchStreamed(d->streamYValues, first, count, out, validMask);
+    return d->fetch(d->yDataRegion, first, count, out, validMask);
+}
+
+void DataSet::fetchXData(int first, int count, QVariant *out) const
+{
+    if (d->isStreaming()) {
+        for (int i = 0; i < count; i++)
+            out[i] = xData(first + i);
+        return;
+    }
+
+    d->fetchCells(d->xDataRegion, first, count, out);
+    // Same fall-back as in xData()
+    for (int i = 0; i < count; i++) {
+        QVariant &data = out[i];
+        if (!data.isValid() || !data.canConvert< double >() || !data.convert(QVariant::Double))
+            data = QVariant(first + i + 1);
+    }
+}
+
+void DataSet::fetchYData(int first, int count, QVariant *out) const
+{
+    if (d->isStreaming()) {
+        for (int i = 0; i < count; i++)
+            out[i] = yData(first + i);
+        return;
+    }
+
+    d->fetchCells(d->yDataRegion, first, count, out);
+}
+
+int DataSet::fetchCustomData(int first, int count, double *out, quint8 *validMask) const
+{
+    return d->fetch(d->customDataRegion, first, count, out, validMask);
+}
+
+void DataSet::fetchCategoryData(int first, int count, QVariant *out) const
+{
+    Q_ASSERT(first >= 0);
+
+    if (d->isStreaming()) {
+        for (int i = 0; i < count; i++)
+            out[i] = d->defaultCategoryLabel(first + i);
+        return;
+    }
+
+    const CellRegion &region = d->categoryDataRegion;
+    QAbstractItemModel *model = d->sourceModel(region);
+    const CellRegion::const_iterator end = region.end();
+    CellRegion::const_iterator it = region.iteratorAt(first);
+
+    // Same fall-backs as in categoryData()
+    for (int i = 0; i < count; i++) {
+        if (it == end) {
+            out[i] = d->defaultCategoryLabel(first + i);
+            continue;
+        }
+
+        const QVariant data = model ? d->cellData(model, *it) : QVariant();
+        out[i] = data.isValid() ? data : QVariant(QString(""));
+        ++it;
+    }
+}
+
+void DataSet::setStreamingCapacity(int capacity)
+{
+    d->streamXValues.setCapacity(capacity);
+    d->streamYValues.setCapacity(capacity);
+    d->streamedCount = 0;
+    d->updateSize();
+
+    if (d->kdChartModel) {
+        d->kdChartModel->dataSetChanged(this, KDChartModel::XDataRole);
+        d->kdChartModel->dataSetChanged(this, KDChartModel::YDataRole);
+    }
+}
+
+int DataSet::streamingCapacity() const
+{
+    return d->streamYValues.capacity();
+}
+
+bool DataSet::isStreaming() const
+{
+    return d->isStreaming();
+}
+
+void DataSet::appendData(const double *xValues, const double *yValues, int count)
+{
+    Q_ASSERT(d->isStreaming());
+    if (!d->isStreaming() || count <= 0)
+        return;
+
+    const int oldCount = d->streamYValues.count();
+    const int removed = d->streamYValues.append(yValues, count);
+    if (xValues) {
+        d->streamXValues.append(xValues, count);
+    } else {
+        // Only the last 'capacity' values survive anyway
+        const int numbered = qMin(count, d->streamXValues.capacity());
+        QVector<double> numbers(numbered);
+        for (int i = 0; i < numbered; i++)
+            numbers[i] = d->streamedCount + count - numbered + i + 1;
+        d->streamXValues.append(numbers.constData(), numbered);
+    }
+    d->streamedCount += count;
+
+    const int newCount = d->streamYValues.count();
+    d->size = newCount;
+    if (d->kdChartModel)
+        d->kdChartModel->dataSetPointsAppended(this, removed, newCount - (oldCount - removed));
+}
+
+void DataSet::appendData(const double *yValues, int count)
+{
+    appendData(0, yValues, count);
+}
+
 QVariant DataSet::labelData() const
 {
     QString label;
@@ -876,6 +1247,9 @@ void DataSet::setXDataRegion(const CellRegion &region)
     d->xDataRegion = region;
     d->updateSize();
 
+    if (d->proxyModel)
+        d->proxyModel->dataSetRegionChanged(this, ChartProxyModel::XDataRole);
+
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::XDataRole);
 }
@@ -885,6 +1259,9 @@ void DataSet::setYDataRegion(const CellRegion &region)
     d->yDataRegion = region;
     d->updateSize();
 
+    if (d->proxyModel)
+        d->proxyModel->dataSetRegionChanged(this, ChartProxyModel::YDataRole);
+
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::YDataRole);
 }
@@ -893,7 +1270,9 @@ void DataSet::setCustomDataRegion(const CellRegion &region)
 {
     d->customDataRegion = region;
     d->updateSize();
-    
+
+    if (d->proxyModel)
+        d->proxyModel->dataSetRegionChanged(this, ChartProxyModel::CustomDataRole);
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::CustomDataRole);
 }
@@ -903,6 +1282,9 @@ void DataSet::setCategoryDataRegion(const CellRegion &region)
     d->categoryDataRegion = region;
     d->updateSize();
 
+    if (d->proxyModel)
+        d->proxyModel->dataSetRegionChanged(this, ChartProxyModel::CategoryDataRole);
+
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this, KDChartModel::CategoryDataRole);
 }
@@ -912,6 +1294,9 @@ void DataSet::setLabelDataRegion(const CellRegion &region)
     d->labelDataRegion = region;
     d->updateSize();
 
+    if (d->proxyModel)
+        d->proxyModel->dataSetRegionChanged(this, ChartProxyModel::LabelDataRole);
+
     if (d->kdChartModel)
         d->kdChartModel->dataSetChanged(this);
 }
@@ -922,15 +1307,58 @@ int DataSet::size() const
     return d->size > 0 ? d->size : 1;
 }
 
-void DataSet::Private::dataChanged(KDChartModel::DataRole role, const QRect &/*rect*/) const
+void DataSet::Private::dataChanged(KDChartModel::DataRole role, const QRect &rect) const
 {
     if (!kdChartModel)
         return;
 
-    // Stubbornly pretend like everything changed. This as well should be
-    // refactored to be done in ChartProxyModel, then we can also fine-tune
-    // it for performance.
-    kdChartModel->dataSetChanged(parent, role, 0, size - 1);
+    const CellRegion *region = 0;
+    switch (role) {
+    case KDChartModel::XDataRole:
+        region = &xDataRegion;
+        break;
+    case KDChartModel::YDataRole:
+        region = &yDataRegion;
+        break;
+    case KDChartModel::CustomDataRole:
+        region = &customDataRegion;
+        break;
+    case KDChartModel::CategoryDataRole:
+        region = &categoryDataRegion;
+        break;
+    default:
+        break;
+    }
+
+    // Without a rectangle, pretend like everything changed
+    if (!region || !rect.isValid()) {
+        kdChartModel->dataSetChanged(parent, role, 0, size - 1);
+        return;
+    }
+
+    // The data points of the region that lie in rect. Each rectangle of
+    // the region is one-dimensional, so its part in rect is a consecutive
+    // range of data points.
+    int first = -1;
+    int last = -1;
+    int offset = 0;
+    foreach (const QRect &regionRect, region->rects()) {
+        const QRect changed = regionRect & rect;
+        if (!changed.isEmpty()) {
+            const bool horizontal = regionRect.width() > 1;
+            const int changedFirst = offset + (horizontal ? changed.left() - regionRect.left()
+                                                          : changed.top() - regionRect.top());
+            const int changedLast = offset + (horizontal ? changed.right() - regionRect.left()
+                                                         : changed.bottom() - regionRect.top());
+            first = first < 0 ? changedFirst : qMin(first, changedFirst);
+            last = qMax(last, changedLast);
+        }
+        offset += regionRect.width() * regionRect.height();
+    }
+
+    if (first < 0)
+        return;
+    kdChartModel->dataSetChanged(parent, role, first, last);
 }
 
 void DataSet::yDataChanged(const QRect &region) const
@@ -973,11 +1401,23 @@ KDChartModel *DataSet::kdChartModel() const
     return d->kdChartModel;
 }
 
+void DataSet::setProxyModel(ChartProxyModel *model)
+{
+    d->proxyModel = model;
+}
+
+ChartProxyModel *DataSet::proxyModel() const
+{
+    return d->proxyModel;
+}
+
 void DataSet::setValueLabelType(ValueLabelType type, int section /* = -1 */)
 {
     if (section >= 0)
         d->insertDataValueAttributeSectionIfNecessary(section);
 
+    d->invalidateAttributeCache(section);
+
     // This is a reference, not a copy!
     KDChart::DataValueAttributes &attr = section >= 0 ?
                                          d->sectionsDataValueAttributes[ section ] :
@@ -1020,9 +1460,9 @@ void DataSet::setValueLabelType(ValueLabelType type, int section /* = -1 */)
 
 DataSet::ValueLabelType DataSet::valueLabelType(int section /* = -1 */) const
 {
-    KDChart::DataValueAttributes &attr = d->dataValueAttributes;
-    if (d->sectionsDataValueAttributes.contains(section))
-        attr = d->sectionsDataValueAttributes[ section ];
+    const KDChart::DataValueAttributes &attr = d->sectionsDataValueAttributes.contains(section) ?
+                                               d->sectionsDataValueAttributes[ section ] :
+                                               d->dataValueAttributes;
     KDChart::TextAttributes ta (attr.textAttributes());
     if (!ta.isVisible())
         return NoValueLabel;
@@ -1212,6 +1652,7 @@ bool DataSet::loadOdf(const KXmlElement &n,
             }
         }
     }
+    d->invalidateAttributeCache();
 
     // load data points
     KXmlElement m;
@@ -42,6 +42,7 @@ namespace KDChart {
 class KShapeLoadingContext;
 
 class KDChartModel;
+class ChartProxyModel;
 
 
 /**
@@ -185,6 +186,55 @@ public:
     QVariant categoryData(int index) const;
     QVariant labelData() const;
 
+    /**
+     * Bulk versions of xData(), yData() and customData() that read the
+     * @a count data points starting at @a first into @a out at once.
+     * Each cell region is walked only once, instead of looking up every
+     * single data point.
+     *
+     * @param validMask If not 0, validMask[i] is set to 1 if out[i] holds
+     * a number and to 0 otherwise, e.g. for empty cells
+     * @return The number of valid values written to @a out
+     */
+    int fetchXData(int first, int count, double *out, quint8 *validMask = 0) const;
+    int fetchYData(int first, int count, double *out, quint8 *validMask = 0) const;
+    int fetchCustomData(int first, int count, double *out, quint8 *validMask = 0) const;
+
+    /**
+     * Bulk versions of xData() and yData() that return the same variants,
+     * e.g. strings or integers as the cells hold them.
+     */
+    void fetchXData(int first, int count, QVariant *out) const;
+    void fetchYData(int first, int count, QVariant *out) const;
+
+    /**
+     * Bulk version of categoryData().
+     */
+    void fetchCategoryData(int first, int count, QVariant *out) const;
+
+    /**
+     * Puts this data set into streaming mode, in which its x and y data is
+     * not taken from cell regions, but appended with appendData() instead.
+     *
+     * Only the last @a capacity data points are kept, i.e. the data set is
+     * a sliding window over the data appended to it. Setting a capacity of
+     * 0 ends streaming mode. Either way, all streamed data is discarded.
+     */
+    void setStreamingCapacity(int capacity);
+    int streamingCapacity() const;
+    bool isStreaming() const;
+
+    /**
+     * Appends @a count data points to a data set in streaming mode, dropping
+     * the oldest ones if the capacity is exceeded. This is O(1) per point,
+     * and the KDChartModel is notified only once per call.
+     *
+     * If @a xValues is 0, the x value of a point is its number, counting
+     * all points ever appended, starting at 1.
+     */
+    void appendData(const double *xValues, const double *yValues, int count);
+    void appendData(const double *yValues, int count);
+
     CellRegion xDataRegion() const;
     CellRegion yDataRegion() const;
     CellRegion customDataRegion() const;
@@ -208,7 +258,7 @@ public:
     void labelDataChanged() const;
     void categoryDataChanged(int start, int end) const;
 
-    // FIXME: The parameter 'region' is unused in the methods below
+    // Only the data points in 'region' changed, or all if it is invalid
     void yDataChanged(const QRect &region) const;
     void xDataChanged(const QRect &region) const;
     void customDataChanged(const QRect &region) const;
@@ -218,6 +268,13 @@ public:
     void setKdChartModel(KDChartModel *model);
     KDChartModel *kdChartModel() const;
 
+    /**
+     * Sets the proxy model this data set belongs to. It is notified
+     * whenever one of the cell regions of this data set changes.
+     */
+    void setProxyModel(ChartProxyModel *model);
+    ChartProxyModel *proxyModel() const;
+
     bool loadOdf(const KXmlElement &n,
                   KShapeLoadingContext &context);
     /**
@@ -26,6 +26,12 @@
 // Own
 #include "KDChartModel.h"
 
+// Qt
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
 // KDE
 #include <KDebug>
 
@@ -84,11 +90,63 @@ public:
 
     bool isKnownDataRole(int role) const;
 
+    /**
+     * The numeric values of one dimension (x or y) of a data set.
+     *
+     * Values in [dirtyFirst, dirtyLast] have been invalidated and are
+     * fetched again in one go the next time any of them is requested.
+     */
+    struct ValueColumn {
+        ValueColumn() : dirtyFirst(0), dirtyLast(-1) {}
+
+        bool isDirty(int index) const { return index >= dirtyFirst && index <= dirtyLast; }
+        void invalidate(int first, int last);
+
+        // What DataSet::xData() respectively yData() return
+        QVector<QVariant> values;
+        int dirtyFirst;
+        int dirtyLast;
+    };
+
+    struct ValueCache {
+        ValueColumn xValues;
+        ValueColumn yValues;
+    };
+
+    /**
+     * Returns the x or y value of data point @a index in @a dataSet,
+     * from the value cache if possible.
+     */
+    QVariant cachedData(DataSet *dataSet, DataRole role, int index);
+
+    /**
+     * Marks the cached values of @a dataSet for @a role in [first, last]
+     * as invalid. A negative @a first invalidates all values.
+     */
+    void invalidateCache(DataSet *dataSet, DataRole role, int first = -1, int last = -1);
+
+    /**
+     * Emits the changes collected since beginUpdate().
+     */
+    void flushPendingChanges();
+
+    // Batched changes, see beginUpdate()
+    int updateDepth;
+    int pendingSignalCount;
+    int suppressedSignalCount;
+    QSet<DataSet*> pendingHeaderChanges;
+    // Range of changed data points per data set
+    QHash<DataSet*, QPair<int, int> > pendingDataChanges;
+
     int             dataDimensions;
     int             biggestDataSetSize;
     QList<DataSet*> dataSets;
 
     Qt::Orientation dataDirection;
+
+    QHash<DataSet*, ValueCache> valueCache;
+    int cacheHits;
+    int cacheMisses;
 };
 
 
@@ -98,6 +156,11 @@ KDChartModel::Private::Private(KDChartModel *parent)
     dataDimensions      = 1;
     dataDirection       = Qt::Vertical;
     biggestDataSetSize  = 0;
+    cacheHits           = 0;
+    cacheMisses         = 0;
+    updateDepth           = 0;
+    pendingSignalCount    = 0;
+    suppressedSignalCount = 0;
 }
 
 KDChartModel::Private::~Private()
@@ -158,6 +221,106 @@ QModelIndex KDChartModel::Private::dataPointLastModelIndex(int dataSetNumber, in
     return q->index(dataSetRowOrCol, index);
 }
 
+void KDChartModel::Private::ValueColumn::invalidate(int first, int last)
+{
+    if (dirtyFirst > dirtyLast) {
+        dirtyFirst = first;
+        dirtyLast = last;
+    } else {
+        dirtyFirst = qMin(dirtyFirst, first);
+        dirtyLast = qMax(dirtyLast, last);
+    }
+}
+
+QVariant KDChartModel::Private::cachedData(DataSet *dataSet, DataRole role, int index)
+{
+    const bool isXData = role == XDataRole;
+    // Streamed data is in memory already
+    if (dataSet->isStreaming())
+        return isXData ? dataSet->xData(index) : dataSet->yData(index);
+
+    const int size = dataSet->size();
+    if (index < 0 || index >= size)
+        return isXData ? dataSet->xData(index) : dataSet->yData(index);
+
+    ValueCache &cache = valueCache[dataSet];
+    ValueColumn &column = isXData ? cache.xValues : cache.yValues;
+    if (column.values.size() != size) {
+        column.values.resize(size);
+        column.invalidate(0, size - 1);
+    }
+
+    if (column.isDirty(index)) {
+        cacheMisses++;
+        const int first = column.dirtyFirst;
+        const int count = qMin(column.dirtyLast, size - 1) - first + 1;
+        if (isXData)
+            dataSet->fetchXData(first, count, column.values.data() + first);
+        else
+            dataSet->fetchYData(first, count, column.values.data() + first);
+        column.dirtyFirst = 0;
+        column.dirtyLast = -1;
+    } else {
+        cacheHits++;
+    }
+
+    return column.values[index];
+}
+
+void KDChartModel::Private::invalidateCache(DataSet *dataSet, DataRole role, int first, int last)
+{
+    QHash<DataSet*, ValueCache>::iterator it = valueCache.find(dataSet);
+    if (it == valueCache.end())
+        return;
+
+    if (first < 0) {
+        first = 0;
+        last = dataSet->size() - 1;
+    } else if (last < 0) {
+        last = first;
+    } else if (last < first) {
+        qSwap(first, last);
+    }
+
+    if (role == XDataRole)
+        it->xValues.invalidate(first, last);
+    else if (role == YDataRole)
+        it->yValues.invalidate(first, last);
+}
+
+void KDChartModel::Private::flushPendingChanges()
+{
+    int emittedSignalCount = 0;
+
+    foreach (DataSet *dataSet, pendingHeaderChanges) {
+        if (!dataSets.contains(dataSet))
+            continue;
+        const int first = dataSetIndex(dataSet) * dataDimensions;
+        emit q->headerDataChanged(dataDirection, first, first + dataDimensions - 1);
+        emittedSignalCount++;
+    }
+
+    const int lastIndex = biggestDataSetSize - 1;
+    QHash<DataSet*, QPair<int, int> >::const_iterator it;
+    for (it = pendingDataChanges.constBegin(); it != pendingDataChanges.constEnd(); ++it) {
+        DataSet *dataSet = it.key();
+        // Rows or columns may have been removed in the meantime
+        const int first = it->first;
+        const int last = qMin(it->second, lastIndex);
+        if (!dataSets.contains(dataSet) || first > last)
+            continue;
+        const int dataSetNumber = dataSetIndex(dataSet);
+        emit q->dataChanged(dataPointFirstModelIndex(dataSetNumber, first),
+                            dataPointLastModelIndex(dataSetNumber, last));
+        emittedSignalCount++;
+    }
+
+    suppressedSignalCount += pendingSignalCount - emittedSignalCount;
+    pendingSignalCount = 0;
+    pendingHeaderChanges.clear();
+    pendingDataChanges.clear();
+}
+
 
 // ================================================================
 //                     class KDChartModel
@@ -227,9 +390,9 @@ QVariant KDChartModel::data(const QModelIndex &index,
     switch (role) {
     case Qt::DisplayRole:
         if (d->dataDimensions > 1 && dataSection == 0)
-            return dataSet->xData(section);
+            return d->cachedData(dataSet, XDataRole, section);
         else
-            return dataSet->yData(section);
+            return d->cachedData(dataSet, YDataRole, section);
     case KDChart::DatasetBrushRole:
         return dataSet->brush(section);
     case KDChart::DatasetPenRole:
@@ -254,6 +417,12 @@ void KDChartModel::dataSetChanged(DataSet *dataSet)
     if (!d->dataSets.contains(dataSet))
         return;
 
+    if (d->updateDepth > 0) {
+        d->pendingHeaderChanges.insert(dataSet);
+        d->pendingSignalCount++;
+        return;
+    }
+
     int dataSetNumber = d->dataSetIndex(dataSet);
 
     // Header data that belongs to this data set (e.g. label)
@@ -262,12 +431,14 @@ void KDChartModel::dataSetChanged(DataSet *dataSet)
     emit headerDataChanged(dataDirection(), first, last);
 }
 
-void KDChartModel::dataSetChanged(DataSet *dataSet, DataRole /*role*/, int first /* = -1 */, int last /* = -1 */)
+void KDChartModel::dataSetChanged(DataSet *dataSet, DataRole role, int first /* = -1 */, int last /* = -1 */)
 {
     Q_ASSERT(d->dataSets.contains(dataSet));
     if (!d->dataSets.contains(dataSet))
         return;
 
+    d->invalidateCache(dataSet, role, first, last);
+
     const int lastIndex = d->biggestDataSetSize - 1;
     // be sure the 'first' and 'last' referenced rows are within our boundaries
     first = qMin(first, lastIndex);
@@ -288,6 +459,18 @@ void KDChartModel::dataSetChanged(DataSet *dataSet, DataRole /*role*/, int first
     if (last < first)
         qSwap(first , last);
 
+    if (d->updateDepth > 0) {
+        QHash<DataSet*, QPair<int, int> >::iterator it = d->pendingDataChanges.find(dataSet);
+        if (it == d->pendingDataChanges.end()) {
+            d->pendingDataChanges.insert(dataSet, qMakePair(first, last));
+        } else {
+            it->first = qMin(it->first, first);
+            it->second = qMax(it->second, last);
+        }
+        d->pendingSignalCount++;
+        return;
+    }
+
     int dataSetNumber = d->dataSetIndex(dataSet);
     emit dataChanged(d->dataPointFirstModelIndex(dataSetNumber, first),
                       d->dataPointLastModelIndex(dataSetNumber, last));
@@ -303,6 +486,9 @@ void KDChartModel::dataSetSizeChanged(DataSet *dataSet, int newSize)
         return;
     }
 
+    // Data points may have moved, so don't trust any of the cached values
+    d->valueCache.remove(dataSet);
+
     // old max data set size is cached
     const int oldMaxSize = d->maxDataSetSize();
     // Determine new max data set size (the size of dataSet has been changed already)
@@ -337,6 +523,60 @@ void KDChartModel::dataSetSizeChanged(DataSet *dataSet, int newSize)
     }
 }
 
+void KDChartModel::dataSetPointsAppended(DataSet *dataSet, int removed, int appended)
+{
+    if (!d->dataSets.contains(dataSet)) {
+        qWarning() << "KDChartModel::dataSetPointsAppended(): The data set is not assigned to this model.";
+        return;
+    }
+
+    d->valueCache.remove(dataSet);
+
+    // The other data sets don't move along, so all data points of this
+    // one changed
+    if (removed > 0 && d->dataSets.size() > 1) {
+        dataSetSizeChanged(dataSet, dataSet->size());
+        dataSetChanged(dataSet, YDataRole);
+        return;
+    }
+
+    if (removed > 0) {
+        if (d->dataDirection == Qt::Horizontal)
+            beginRemoveColumns(QModelIndex(), 0, removed - 1);
+        else
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+
+        d->biggestDataSetSize -= removed;
+
+        if (d->dataDirection == Qt::Horizontal)
+            endRemoveColumns();
+        else
+            endRemoveRows();
+    }
+
+    // Appended data points beyond the end of the model are new rows or
+    // columns, the others just changed
+    const int oldMaxSize = d->maxDataSetSize();
+    const int newMaxSize = d->calcMaxDataSetSize();
+    const int firstAppended = dataSet->size() - appended;
+    if (firstAppended < oldMaxSize)
+        dataSetChanged(dataSet, YDataRole, firstAppended, qMin(dataSet->size(), oldMaxSize) - 1);
+
+    if (newMaxSize > oldMaxSize) {
+        if (d->dataDirection == Qt::Horizontal)
+            beginInsertColumns(QModelIndex(), oldMaxSize, newMaxSize - 1);
+        else
+            beginInsertRows(QModelIndex(), oldMaxSize, newMaxSize - 1);
+
+        d->biggestDataSetSize = newMaxSize;
+
+        if (d->dataDirection == Qt::Horizontal)
+            endInsertColumns();
+        else
+            endInsertRows();
+    }
+}
+
 void KDChartModel::slotColumnsInserted(const QModelIndex& parent,
                                         int start, int end)
 {
@@ -349,15 +589,33 @@ void KDChartModel::slotColumnsInserted(const QModelIndex& parent,
     }
 }
 
+/**
+ * The KDChart attributes roles this model provides data for, shared by
+ * attributesRoles() and isKnownDataRole().
+ */
+static const int modelAttributesRoles[] = {
+    KDChart::DatasetPenRole,
+    KDChart::DatasetBrushRole,
+    KDChart::PieAttributesRole,
+    KDChart::DataValueLabelAttributesRole
+};
+static const int modelAttributesRoleCount = sizeof(modelAttributesRoles) / sizeof(modelAttributesRoles[0]);
+
+QList<int> KDChartModel::attributesRoles()
+{
+    QList<int> roles;
+    for (int i = 0; i < modelAttributesRoleCount; ++i)
+        roles << modelAttributesRoles[i];
+    return roles;
+}
+
 bool KDChartModel::Private::isKnownDataRole(int role) const
 {
-    switch (role) {
-    case Qt::DisplayRole:
-    case KDChart::DatasetPenRole:
-    case KDChart::DatasetBrushRole:
-    case KDChart::PieAttributesRole:
-    case KDChart::DataValueLabelAttributesRole:
+    if (role == Qt::DisplayRole)
         return true;
+    for (int i = 0; i < modelAttributesRoleCount; ++i) {
+        if (modelAttributesRoles[i] == role)
+            return true;
     }
 
     return false;
@@ -550,6 +808,10 @@ void KDChartModel::removeDataSet(DataSet *dataSet, bool silent)
     if (dataSetIndex < 0)
         return;
 
+    d->valueCache.remove(dataSet);
+    d->pendingHeaderChanges.remove(dataSet);
+    d->pendingDataChanges.remove(dataSet);
+
     if (silent) {
         d->dataSets.removeAt(dataSetIndex);
         d->biggestDataSetSize = d->calcMaxDataSetSize();
@@ -597,4 +859,45 @@ QList<DataSet*> KDChartModel::dataSets() const
     return d->dataSets;
 }
 
+void KDChartModel::beginUpdate()
+{
+    d->updateDepth++;
+}
+
+void KDChartModel::endUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (d->updateDepth <= 0)
+        return;
+
+    if (--d->updateDepth == 0)
+        d->flushPendingChanges();
+}
+
+bool KDChartModel::isUpdating() const
+{
+    return d->updateDepth > 0;
+}
+
+int KDChartModel::suppressedSignalCount() const
+{
+    return d->suppressedSignalCount;
+}
+
+int KDChartModel::cacheHits() const
+{
+    return d->cacheHits;
+}
+
+int KDChartModel::cacheMisses() const
+{
+    return d->cacheMisses;
+}
+
+void KDChartModel::resetCacheStatistics()
+{
+    d->cacheHits = 0;
+    d->cacheMisses = 0;
+}
+
 #include "KDChartModel.moc"
@@ -107,6 +107,12 @@ public:
      */
     Qt::Orientation categoryDirection() const;
 
+    /**
+     * Returns the KDChart attributes roles this model provides data for.
+     * All other attributes are left to the diagram's attributes model.
+     */
+    static QList<int> attributesRoles();
+
 public slots:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
@@ -152,6 +158,57 @@ public slots:
      */
     void dataSetSizeChanged(DataSet *dataSet, int newSize);
 
+    /**
+     * Called by a DataSet in streaming mode when @a appended data points
+     * have been appended to it, and the @a removed oldest ones dropped.
+     *
+     * If this is the only data set in the model, this is signalled as
+     * the removal of the first and the insertion of the last data points,
+     * so that views can shift their data instead of reloading all of it.
+     */
+    void dataSetPointsAppended(DataSet *dataSet, int removed, int appended);
+
+public:
+    /**
+     * Starts a batch of changes. Until the matching endUpdate(), calls to
+     * dataSetChanged() don't emit anything but are collected instead, and
+     * merged into one range per data set.
+     *
+     * Calls can be nested, only the outermost endUpdate() emits. Changes
+     * in the structure of the model, e.g. inserted rows, are still
+     * signalled immediately.
+     */
+    void beginUpdate();
+
+    /**
+     * Ends a batch of changes started with beginUpdate() and emits one
+     * dataChanged() and one headerDataChanged() signal per changed
+     * data set.
+     */
+    void endUpdate();
+
+    bool isUpdating() const;
+
+    /**
+     * The total number of signals that were not emitted because they were
+     * merged with others in between beginUpdate() and endUpdate().
+     */
+    int suppressedSignalCount() const;
+
+    /**
+     * The x and y values of the data sets are cached in this model,
+     * so that repeated requests for the same data point don't have to go
+     * all the way down to the source model. The cache of a data set is
+     * invalidated by dataSetChanged() and dataSetSizeChanged().
+     *
+     * cacheHits() is the number of Qt::DisplayRole requests answered from
+     * the cache, cacheMisses() the number of requests that had to refill
+     * the (invalidated part of the) cache first.
+     */
+    int cacheHits() const;
+    int cacheMisses() const;
+    void resetCacheStatistics();
+
 private:
     class Private;
     Private *const d;
@@ -0,0 +1,135 @@
+/* This file is part of the KDE project
+
+   Copyright 2026 agent <agent@local>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KCHART_RINGBUFFER_H
+#define KCHART_RINGBUFFER_H
+
+// Qt
+#include <QVector>
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+
+/**
+ * @brief A fixed-capacity FIFO of values, used as a sliding window.
+ *
+ * Appending to a full buffer overwrites the oldest values, so appending
+ * is O(1) per value and never moves or reallocates any data.
+ * Values are addressed from the oldest (0) to the newest (count() - 1).
+ */
+template<typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0)
+        : m_first(0)
+        , m_count(0)
+    {
+        setCapacity(capacity);
+    }
+
+    /**
+     * Changes the capacity of this buffer. All values are discarded.
+     */
+    void setCapacity(int capacity)
+    {
+        m_data = QVector<T>(qMax(0, capacity));
+        clear();
+    }
+
+    int capacity() const { return m_data.size(); }
+    int count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    bool isFull() const { return m_count == m_data.size(); }
+
+    void clear()
+    {
+        m_first = 0;
+        m_count = 0;
+    }
+
+    const T &at(int index) const
+    {
+        Q_ASSERT(index >= 0 && index < m_count);
+        return m_data.at(physicalIndex(index));
+    }
+
+    /**
+     * Appends @a count values, dropping as many of the oldest ones as
+     * necessary to make room for them.
+     *
+     * @return The number of previously stored values that were dropped
+     */
+    int append(const T *values, int count)
+    {
+        const int capacity = m_data.size();
+        if (capacity == 0 || count <= 0)
+            return 0;
+
+        // Only the last 'capacity' values can survive
+        const int dropped = qBound(0, m_count + count - capacity, m_count);
+        if (count > capacity) {
+            values += count - capacity;
+            count = capacity;
+        }
+
+        T *data = m_data.data();
+        // Right behind the newest value, i.e. on the oldest one if full
+        int pos = physicalIndex(m_count);
+        for (int i = 0; i < count; i++) {
+            data[pos] = values[i];
+            if (++pos == capacity)
+                pos = 0;
+        }
+
+        const int newCount = qMin(capacity, m_count + count);
+        m_first = physicalIndex(m_count + count - newCount);
+        m_count = newCount;
+
+        return dropped;
+    }
+
+    /**
+     * Copies the @a count values starting at @a first to @a out, in at
+     * most two contiguous chunks.
+     */
+    void copy(int first, int count, T *out) const
+    {
+        Q_ASSERT(first >= 0 && first + count <= m_count);
+        const int start = physicalIndex(first);
+        const int head = qMin(count, m_data.size() - start);
+        qCopy(m_data.constData() + start, m_data.constData() + start + head, out);
+        qCopy(m_data.constData(), m_data.constData() + count - head, out + head);
+    }
+
+private:
+    int physicalIndex(int index) const
+    {
+        const int pos = m_first + index;
+        return pos >= m_data.size() ? pos - m_data.size() : pos;
+    }
+
+    QVector<T> m_data;
+    // Physical position of the oldest value
+    int m_first;
+    int m_count;
+};
+
+#endif // KCHART_RINGBUFFER_H
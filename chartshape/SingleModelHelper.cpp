@@ -40,13 +40,13 @@ SingleModelHelper::SingleModelHelper(Table *table, ChartProxyModel *proxyModel)
     connect(model, SIGNAL(modelReset()),
              this,  SLOT(slotModelStructureChanged()));
     connect(model, SIGNAL(rowsInserted(QModelIndex, int, int)),
-             this,  SLOT(slotModelStructureChanged()));
+             this,  SLOT(slotRowsInserted(QModelIndex, int, int)));
     connect(model, SIGNAL(rowsRemoved(QModelIndex, int, int)),
-             this,  SLOT(slotModelStructureChanged()));
+             this,  SLOT(slotRowsRemoved(QModelIndex, int, int)));
     connect(model, SIGNAL(columnsInserted(QModelIndex, int, int)),
-             this,  SLOT(slotModelStructureChanged()));
+             this,  SLOT(slotColumnsInserted(QModelIndex, int, int)));
     connect(model, SIGNAL(columnsRemoved(QModelIndex, int, int)),
-             this,  SLOT(slotModelStructureChanged()));
+             this,  SLOT(slotColumnsRemoved(QModelIndex, int, int)));
 
     // Initialize the proxy with this model
     slotModelStructureChanged();
@@ -59,3 +59,31 @@ void SingleModelHelper::slotModelStructureChanged()
     QPoint bottomRight(model->columnCount(), model->rowCount());
     m_proxyModel->reset(CellRegion(m_table, QRect(topLeft, bottomRight)));
 }
+
+// Appending data points to the series, e.g. a new row for each series in
+// columns, only extends the existing data sets. Everything else requires
+// them to be re-created.
+
+void SingleModelHelper::slotRowsInserted(const QModelIndex &/*parent*/, int start, int end)
+{
+    if (!m_proxyModel->tableRowsInserted(m_table, start, end))
+        slotModelStructureChanged();
+}
+
+void SingleModelHelper::slotColumnsInserted(const QModelIndex &/*parent*/, int start, int end)
+{
+    if (!m_proxyModel->tableColumnsInserted(m_table, start, end))
+        slotModelStructureChanged();
+}
+
+void SingleModelHelper::slotRowsRemoved(const QModelIndex &/*parent*/, int start, int end)
+{
+    if (!m_proxyModel->tableRowsRemoved(m_table, start, end))
+        slotModelStructureChanged();
+}
+
+void SingleModelHelper::slotColumnsRemoved(const QModelIndex &/*parent*/, int start, int end)
+{
+    if (!m_proxyModel->tableColumnsRemoved(m_table, start, end))
+        slotModelStructureChanged();
+}
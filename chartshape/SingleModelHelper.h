@@ -24,10 +24,14 @@
 // Qt
 #include <QObject>
 
+// KChart
+#include "kchart_export.h"
+
+class QModelIndex;
 class ChartProxyModel;
 class Table;
 
-class SingleModelHelper : public QObject
+class CHARTSHAPE_TEST_EXPORT SingleModelHelper : public QObject
 {
     Q_OBJECT
 
@@ -36,6 +40,10 @@ public:
 
 private slots:
     void slotModelStructureChanged();
+    void slotRowsInserted(const QModelIndex &parent, int start, int end);
+    void slotColumnsInserted(const QModelIndex &parent, int start, int end);
+    void slotRowsRemoved(const QModelIndex &parent, int start, int end);
+    void slotColumnsRemoved(const QModelIndex &parent, int start, int end);
 
 private:
     Table *const m_table;
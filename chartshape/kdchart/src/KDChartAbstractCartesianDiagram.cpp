@@ -84,6 +84,8 @@ void AbstractCartesianDiagram::init()
     d->compressor.setModel( attributesModel() );
     connect( this, SIGNAL( layoutChanged( AbstractDiagram* ) ),
              &( d->compressor ), SLOT( slotDiagramLayoutChanged( AbstractDiagram* ) ) );
+    connect( this, SIGNAL( dataHidden() ),
+             &( d->compressor ), SLOT( slotDiagramDataHidden() ) );
 }
 
 void AbstractCartesianDiagram::addAxis( CartesianAxis *axis )
@@ -24,6 +24,7 @@
 #include "KDChartAbstractDiagram_p.h"
 
 #include <QPainter>
+#include <QPaintEngine>
 #include <QDebug>
 #include <QApplication>
 #include <QAbstractProxyModel>
@@ -31,6 +32,7 @@
 #include <QStandardItemModel>
 #include <QSizeF>
 #include <QTextDocument>
+#include <QtCore/qmath.h>
 
 #include "KDChartAbstractCoordinatePlane.h"
 #include "KDChartChart.h"
@@ -494,6 +496,32 @@ bool AbstractDiagram::allowOverlappingDataValueTexts() const
     return d->allowOverlappingDataValueTexts;
 }
 
+void AbstractDiagram::setMarkerSpriteCacheSize( int kiloBytes )
+{
+    d->markerSprites.clear();
+    d->markerSprites.setMaxCost( kiloBytes );
+}
+
+int AbstractDiagram::markerSpriteCacheSize() const
+{
+    return d->markerSprites.maxCost();
+}
+
+int AbstractDiagram::markerSpriteCount() const
+{
+    return d->markerSprites.count();
+}
+
+int AbstractDiagram::markerSpriteCacheHits() const
+{
+    return d->markerSprites.hits();
+}
+
+int AbstractDiagram::markerSpriteCacheMisses() const
+{
+    return d->markerSprites.misses();
+}
+
 void AbstractDiagram::setAntiAliasing( bool enabled )
 {
     d->antiAliasing = enabled;
@@ -609,6 +637,214 @@ void AbstractDiagram::paintMarker( QPainter* painter,
     paintMarker( painter, dataValueAttributes( index ), index, pos );
 }
 
+/*
+ * Paints the shape of a marker centered on the origin, using the pen and
+ * brush already set on \a painter.
+ */
+static void paintMarkerShape( QPainter* painter,
+                              const MarkerAttributes& markerAttributes,
+                              const QBrush& brush,
+                              const QSizeF& maSize )
+{
+    switch ( markerAttributes.markerStyle() ) {
+        case MarkerAttributes::MarkerCircle:
+        {
+            if ( markerAttributes.threeD() ) {
+                QRadialGradient grad;
+                grad.setCoordinateMode( QGradient::ObjectBoundingMode );
+                QColor drawColor = brush.color();
+                grad.setCenter( 0.5, 0.5 );
+                grad.setRadius( 1.0 );
+                grad.setFocalPoint( 0.35, 0.35 );
+                grad.setColorAt( 0.00, drawColor.lighter( 150 ) );
+                grad.setColorAt( 0.20, drawColor );
+                grad.setColorAt( 0.50, drawColor.darker( 150 ) );
+                grad.setColorAt( 0.75, drawColor.darker( 200 ) );
+                grad.setColorAt( 0.95, drawColor.darker( 250 ) );
+                grad.setColorAt( 1.00, drawColor.darker( 200 ) );
+                QBrush newBrush( grad );
+                newBrush.setMatrix( brush.matrix() );
+                painter->setBrush( newBrush );
+            }
+            painter->drawEllipse( QRectF( 0 - maSize.height()/2, 0 - maSize.width()/2,
+                        maSize.height(), maSize.width()) );
+        }
+            break;
+        case MarkerAttributes::MarkerSquare:
+            {
+                QRectF rect( 0 - maSize.width()/2, 0 - maSize.height()/2,
+                            maSize.width(), maSize.height() );
+                painter->drawRect( rect );
+                break;
+            }
+        case MarkerAttributes::MarkerDiamond:
+            {
+                QVector <QPointF > diamondPoints;
+                QPointF top, left, bottom, right;
+                top    = QPointF( 0, 0 - maSize.height()/2 );
+                left   = QPointF( 0 - maSize.width()/2, 0 );
+                bottom = QPointF( 0, maSize.height()/2 );
+                right  = QPointF( maSize.width()/2, 0 );
+                diamondPoints << top << left << bottom << right;
+                painter->drawPolygon( diamondPoints );
+                break;
+            }
+        // both handled on top of the method:
+        case MarkerAttributes::Marker1Pixel:
+        case MarkerAttributes::Marker4Pixels:
+                break;
+        case MarkerAttributes::MarkerRing:
+            {
+                painter->setPen( PrintingParameters::scalePen( QPen( brush.color() ) ) );
+                painter->setBrush( Qt::NoBrush );
+                painter->drawEllipse( QRectF( 0 - maSize.height()/2, 0 - maSize.width()/2,
+                                    maSize.height(), maSize.width()) );
+                break;
+            }
+        case MarkerAttributes::MarkerCross:
+            {
+                // Note: Markers can have outline,
+                //       so just drawing two rects is NOT the solution here!
+                const qreal w02 = maSize.width() * 0.2;
+                const qreal w05 = maSize.width() * 0.5;
+                const qreal h02 = maSize.height()* 0.2;
+                const qreal h05 = maSize.height()* 0.5;
+                QVector <QPointF > crossPoints;
+                QPointF p[12];
+                p[ 0] = QPointF( -w02, -h05 );
+                p[ 1] = QPointF(  w02, -h05 );
+                p[ 2] = QPointF(  w02, -h02 );
+                p[ 3] = QPointF(  w05, -h02 );
+                p[ 4] = QPointF(  w05,  h02 );
+                p[ 5] = QPointF(  w02,  h02 );
+                p[ 6] = QPointF(  w02,  h05 );
+                p[ 7] = QPointF( -w02,  h05 );
+                p[ 8] = QPointF( -w02,  h02 );
+                p[ 9] = QPointF( -w05,  h02 );
+                p[10] = QPointF( -w05, -h02 );
+                p[11] = QPointF( -w02, -h02 );
+                for( int i=0; i<12; ++i )
+                    crossPoints << p[i];
+                crossPoints << p[0];
+                painter->drawPolygon( crossPoints );
+                break;
+            }
+        case MarkerAttributes::MarkerFastCross:
+            {
+                QPointF left, right, top, bottom;
+                left  = QPointF( -maSize.width()/2, 0 );
+                right = QPointF( maSize.width()/2, 0 );
+                top   = QPointF( 0, -maSize.height()/2 );
+                bottom= QPointF( 0, maSize.height()/2 );
+                painter->setPen( PrintingParameters::scalePen( QPen( brush.color() ) ) );
+                painter->drawLine( left, right );
+                painter->drawLine(  top, bottom );
+                break;
+            }
+        case MarkerAttributes::NoMarker:
+            break;
+        default:
+            Q_ASSERT_X ( false, "paintMarkers()",
+                        "Type item does not match a defined Marker Type." );
+    }
+}
+
+/*
+ * Whether the sprites can stand in for the marker shapes, i.e. whether
+ * the painter paints pixels on screen or into an image, as opposed to
+ * printing or producing vector output.
+ */
+static bool paintsToRaster( QPainter* painter )
+{
+    const QPaintEngine* const engine = painter->paintEngine();
+    if ( !engine )
+        return false;
+    switch ( engine->type() ) {
+    case QPaintEngine::Raster:
+    case QPaintEngine::X11:
+    case QPaintEngine::Windows:
+    case QPaintEngine::CoreGraphics:
+    case QPaintEngine::OpenGL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool AbstractDiagram::Private::paintMarkerSprite( QPainter* painter,
+                                                  const MarkerAttributes& markerAttributes,
+                                                  const QBrush& brush,
+                                                  const QPen& pen,
+                                                  const QPointF& pos,
+                                                  const QSizeF& maSize )
+{
+    // Sprites larger than this aren't worth their memory
+    static const int MaxSpriteSize = 64;
+
+    if ( markerSprites.maxCost() == 0 || !paintsToRaster( painter ) || painter->viewTransformEnabled() )
+        return false;
+    // only unrotated, unmirrored markers in plain colors
+    const QTransform transform( painter->worldTransform() );
+    if ( transform.type() > QTransform::TxScale || transform.m11() <= 0.0 || transform.m22() <= 0.0 )
+        return false;
+    if ( ( brush.style() != Qt::SolidPattern && brush.style() != Qt::NoBrush ) ||
+         !brush.matrix().isIdentity() || pen.brush().style() != Qt::SolidPattern )
+        return false;
+
+    const bool usesBrushColorPen = markerAttributes.markerStyle() == MarkerAttributes::MarkerRing ||
+                                   markerAttributes.markerStyle() == MarkerAttributes::MarkerFastCross;
+    QPen painterPen( pen );
+    painterPen.setStyle( Qt::SolidLine );
+    painterPen = PrintingParameters::scalePen( painterPen );
+    const QPen shapePen( usesBrushColorPen ? PrintingParameters::scalePen( QPen( brush.color() ) )
+                                           : painterPen );
+
+    MarkerSpriteCache::Key key;
+    key.style = markerAttributes.markerStyle();
+    key.threeD = markerAttributes.threeD();
+    key.size = maSize;
+    key.scaleX = transform.m11();
+    key.scaleY = transform.m22();
+    key.penColor = shapePen.color().rgba();
+    key.penWidth = shapePen.widthF();
+    key.brushColor = brush.color().rgba();
+    key.brushStyle = brush.style();
+
+    // Circles and rings swap width and height, so make room for both
+    const qreal scale = qMax( key.scaleX, key.scaleY );
+    const qreal penExtent = shapePen.widthF() == 0.0 ? 1.0 : shapePen.widthF() * scale;
+    const int spriteSize = qCeil( qMax( maSize.width(), maSize.height() ) * scale + penExtent ) + 2;
+    if ( spriteSize > MaxSpriteSize )
+        return false;
+
+    const QImage* sprite = markerSprites.sprite( key );
+    if ( !sprite ) {
+        QImage image( spriteSize, spriteSize, QImage::Format_ARGB32_Premultiplied );
+        image.fill( 0 );
+        {
+            QPainter imagePainter( &image );
+            imagePainter.setRenderHint( QPainter::Antialiasing );
+            imagePainter.translate( spriteSize / 2.0, spriteSize / 2.0 );
+            imagePainter.scale( key.scaleX, key.scaleY );
+            imagePainter.setPen( painterPen );
+            imagePainter.setBrush( brush );
+            paintMarkerShape( &imagePainter, markerAttributes, brush, maSize );
+        }
+        sprite = markerSprites.insert( key, image );
+        if ( !sprite ) {
+            // too large for the cache
+            return false;
+        }
+    }
+
+    const QPointF center( transform.map( pos ) );
+    const PainterSaver painterSaver( painter );
+    painter->setWorldTransform( QTransform() );
+    painter->drawImage( QPoint( qRound( center.x() - spriteSize / 2.0 ),
+                                qRound( center.y() - spriteSize / 2.0 ) ), *sprite );
+    return true;
+}
+
 void AbstractDiagram::paintMarker( QPainter* painter,
                                    const MarkerAttributes& markerAttributes,
                                    const QBrush& brush,
@@ -634,7 +870,7 @@ void AbstractDiagram::paintMarker( QPainter* painter,
                                QPointF(x+1.0,y+1.0) );
         }
         painter->drawPoint( pos );
-    }else{
+    }else if( ! d->paintMarkerSprite( painter, markerAttributes, brush, pen, pos, maSize ) ){
         const PainterSaver painterSaver( painter );
         // we only a solid line surrounding the markers
         QPen painterPen( pen );
@@ -643,107 +879,7 @@ void AbstractDiagram::paintMarker( QPainter* painter,
         painter->setBrush( brush );
         painter->setRenderHint ( QPainter::Antialiasing );
         painter->translate( pos );
-        switch ( markerAttributes.markerStyle() ) {
-            case MarkerAttributes::MarkerCircle:
-            {
-                if ( markerAttributes.threeD() ) {
-                    QRadialGradient grad;
-                    grad.setCoordinateMode( QGradient::ObjectBoundingMode );
-                    QColor drawColor = brush.color();
-                    grad.setCenter( 0.5, 0.5 );
-                    grad.setRadius( 1.0 );
-                    grad.setFocalPoint( 0.35, 0.35 );
-                    grad.setColorAt( 0.00, drawColor.lighter( 150 ) );
-                    grad.setColorAt( 0.20, drawColor );
-                    grad.setColorAt( 0.50, drawColor.darker( 150 ) );
-                    grad.setColorAt( 0.75, drawColor.darker( 200 ) );
-                    grad.setColorAt( 0.95, drawColor.darker( 250 ) );
-                    grad.setColorAt( 1.00, drawColor.darker( 200 ) );
-                    QBrush newBrush( grad );
-                    newBrush.setMatrix( brush.matrix() );
-                    painter->setBrush( newBrush );
-                }
-                painter->drawEllipse( QRectF( 0 - maSize.height()/2, 0 - maSize.width()/2,
-                            maSize.height(), maSize.width()) );
-            }
-                break;
-            case MarkerAttributes::MarkerSquare:
-                {
-                    QRectF rect( 0 - maSize.width()/2, 0 - maSize.height()/2,
-                                maSize.width(), maSize.height() );
-                    painter->drawRect( rect );
-                    break;
-                }
-            case MarkerAttributes::MarkerDiamond:
-                {
-                    QVector <QPointF > diamondPoints;
-                    QPointF top, left, bottom, right;
-                    top    = QPointF( 0, 0 - maSize.height()/2 );
-                    left   = QPointF( 0 - maSize.width()/2, 0 );
-                    bottom = QPointF( 0, maSize.height()/2 );
-                    right  = QPointF( maSize.width()/2, 0 );
-                    diamondPoints << top << left << bottom << right;
-                    painter->drawPolygon( diamondPoints );
-                    break;
-                }
-            // both handled on top of the method:
-            case MarkerAttributes::Marker1Pixel:
-            case MarkerAttributes::Marker4Pixels:
-                    break;
-            case MarkerAttributes::MarkerRing:
-                {
-                    painter->setPen( PrintingParameters::scalePen( QPen( brush.color() ) ) );
-                    painter->setBrush( Qt::NoBrush );
-                    painter->drawEllipse( QRectF( 0 - maSize.height()/2, 0 - maSize.width()/2,
-                                        maSize.height(), maSize.width()) );
-                    break;
-                }
-            case MarkerAttributes::MarkerCross:
-                {
-                    // Note: Markers can have outline,
-                    //       so just drawing two rects is NOT the solution here!
-                    const qreal w02 = maSize.width() * 0.2;
-                    const qreal w05 = maSize.width() * 0.5;
-                    const qreal h02 = maSize.height()* 0.2;
-                    const qreal h05 = maSize.height()* 0.5;
-                    QVector <QPointF > crossPoints;
-                    QPointF p[12];
-                    p[ 0] = QPointF( -w02, -h05 );
-                    p[ 1] = QPointF(  w02, -h05 );
-                    p[ 2] = QPointF(  w02, -h02 );
-                    p[ 3] = QPointF(  w05, -h02 );
-                    p[ 4] = QPointF(  w05,  h02 );
-                    p[ 5] = QPointF(  w02,  h02 );
-                    p[ 6] = QPointF(  w02,  h05 );
-                    p[ 7] = QPointF( -w02,  h05 );
-                    p[ 8] = QPointF( -w02,  h02 );
-                    p[ 9] = QPointF( -w05,  h02 );
-                    p[10] = QPointF( -w05, -h02 );
-                    p[11] = QPointF( -w02, -h02 );
-                    for( int i=0; i<12; ++i )
-                        crossPoints << p[i];
-                    crossPoints << p[0];
-                    painter->drawPolygon( crossPoints );
-                    break;
-                }
-            case MarkerAttributes::MarkerFastCross:
-                {
-                    QPointF left, right, top, bottom;
-                    left  = QPointF( -maSize.width()/2, 0 );
-                    right = QPointF( maSize.width()/2, 0 );
-                    top   = QPointF( 0, -maSize.height()/2 );
-                    bottom= QPointF( 0, maSize.height()/2 );
-                    painter->setPen( PrintingParameters::scalePen( QPen( brush.color() ) ) );
-                    painter->drawLine( left, right );
-                    painter->drawLine(  top, bottom );
-                    break;
-                }
-            case MarkerAttributes::NoMarker:
-                break;
-            default:
-                Q_ASSERT_X ( false, "paintMarkers()",
-                            "Type item does not match a defined Marker Type." );
-        }
+        paintMarkerShape( painter, markerAttributes, brush, maSize );
     }
     painter->setPen( oldPen );
 }
@@ -633,6 +633,28 @@ namespace KDChart {
         void paintMarker( QPainter* painter,
                           const QModelIndex& index,
                           const QPointF& pos );
+
+        /**
+         * Sets the maximum memory, in kilobytes, taken by the prerendered
+         * sprites that markers are painted from on screen.
+         * 0 disables the sprites, so all markers are painted as vector shapes.
+         * Printing and vector output never use the sprites.
+         * The default is 1024.
+         */
+        void setMarkerSpriteCacheSize( int kiloBytes );
+        int markerSpriteCacheSize() const;
+        /** Returns the number of sprites cached right now. */
+        int markerSpriteCount() const;
+        /**
+         * Returns the number of markers that have been painted from a cached
+         * sprite since the cache size was last set.
+         */
+        int markerSpriteCacheHits() const;
+        /**
+         * Returns the number of marker sprites that have been rendered
+         * since the cache size was last set.
+         */
+        int markerSpriteCacheMisses() const;
         void paintDataValueText( QPainter* painter, const QModelIndex& index,
                                  const QPointF& pos, double value );
 
@@ -36,6 +36,7 @@
 
 #include "KDChartAbstractDiagram.h"
 #include "KDChartAbstractCoordinatePlane.h"
+#include "KDChartAttributesModel.h"
 #include "KDChartDataValueAttributes.h"
 #include "KDChartBackgroundAttributes"
 #include "KDChartRelativePosition.h"
@@ -46,6 +47,7 @@
 #include "KDChartChart.h"
 #include <KDChartCartesianDiagramDataCompressor_p.h>
 #include "Scenery/ReverseMapper.h"
+#include "PrerenderedElements/KDChartMarkerSpriteCache.h"
 
 #include <QMap>
 #include <QPoint>
@@ -96,6 +98,15 @@ namespace KDChart {
 
         void setAttributesModel( AttributesModel* );
 
+        /**
+         * Paints a marker from a cached sprite, if the painter paints to a
+         * raster device. Returns false if the marker needs to be painted as
+         * a vector shape instead.
+         */
+        bool paintMarkerSprite( QPainter* painter, const MarkerAttributes& markerAttributes,
+                                const QBrush& brush, const QPen& pen,
+                                const QPointF& pos, const QSizeF& maSize );
+
         bool usesExternalAttributesModel()const;
 
         // FIXME: Optimize if necessary
@@ -522,6 +533,7 @@ namespace KDChart {
         mutable QPair<QPointF,QPointF> databoundaries;
         mutable bool databoundariesDirty;
         ReverseMapper reverseMapper;
+        MarkerSpriteCache markerSprites;
         /// The size of the diagram set by AbstractDiagram::resize()
         QSizeF diagramSize;
 
@@ -566,5 +578,63 @@ namespace KDChart {
     typedef QVector<LineAttributesInfo> LineAttributesInfoList;
     typedef QVectorIterator<LineAttributesInfo> LineAttributesInfoListIterator;
 
+    /**
+     * Walks the spans AttributesModel::columnSpans() returned for one column,
+     * converting the value of each span only once.
+     * Looking up rows in ascending order is cheapest.
+     */
+    template< typename T >
+    class AttributesSpanCursor {
+        public :
+        AttributesSpanCursor() : mColumn( -1 ), mCurrent( 0 ), mConverted( -1 ) {}
+
+        void reset( int column, const QVector<AttributesModel::Span>& spans )
+        {
+            mColumn = column;
+            mSpans = spans;
+            mCurrent = 0;
+            mConverted = -1;
+        }
+
+        int column() const { return mColumn; }
+
+        bool contains( const QModelIndex& index ) const
+        {
+            return index.isValid() && index.column() == mColumn && !mSpans.isEmpty() &&
+                   index.row() >= mSpans.first().first && index.row() <= mSpans.last().last;
+        }
+
+        const T& value( int row )
+        {
+            if ( mSpans.at( mCurrent ).first > row ) {
+                // going backwards, search the first span not ending before row
+                int low = 0;
+                int high = mCurrent;
+                while ( low < high ) {
+                    const int mid = ( low + high ) / 2;
+                    if ( mSpans.at( mid ).last < row )
+                        low = mid + 1;
+                    else
+                        high = mid;
+                }
+                mCurrent = low;
+            }
+            while ( mSpans.at( mCurrent ).last < row )
+                ++mCurrent;
+            if ( mConverted != mCurrent ) {
+                mValue = qVariantValue< T >( mSpans.at( mCurrent ).value );
+                mConverted = mCurrent;
+            }
+            return mValue;
+        }
+
+        private :
+        int mColumn;
+        QVector<AttributesModel::Span> mSpans;
+        int mCurrent;
+        int mConverted;
+        T mValue;
+    };
+
 }
 #endif /* KDCHARTDIAGRAM_P_H */
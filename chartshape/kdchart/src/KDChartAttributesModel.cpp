@@ -51,7 +51,8 @@ using namespace KDChart;
 
 AttributesModel::AttributesModel( QAbstractItemModel* model, QObject * parent/* = 0 */ )
   : AbstractProxyModel( parent ),
-    mPaletteType( PaletteTypeDefault )
+    mPaletteType( PaletteTypeDefault ),
+    mSourceModelRolesRestricted( false )
 {
     setSourceModel(model);
     setDefaultForRole( KDChart::DataValueLabelAttributesRole,
@@ -66,11 +67,12 @@ void AttributesModel::initFrom( const AttributesModel* other )
 {
     if( other == this || ! other ) return;
 
-    mDataMap = other->mDataMap;
+    mCellData = other->mCellData;
     mHorizontalHeaderDataMap = other->mHorizontalHeaderDataMap;
     mVerticalHeaderDataMap = other->mVerticalHeaderDataMap;
     mModelDataMap = other->mModelDataMap;
     mDefaultsMap =  other->mDefaultsMap;
+    mColumnData.clear();
 
     setPaletteType( other->paletteType() );
 }
@@ -84,47 +86,34 @@ bool AttributesModel::compare( const AttributesModel* other )const
     }
 
     {
-        if (mDataMap.count() != other->mDataMap.count()){
-            //qDebug() << "AttributesModel::compare() dataMap have different sizes";
+        if (mCellData.count() != other->mCellData.count()){
+            //qDebug() << "AttributesModel::compare() cell data have different numbers of roles";
             return false;
         }
-        QMap<int, QMap<int, QMap<int, QVariant> > >::const_iterator itA = mDataMap.constBegin();
-        QMap<int, QMap<int, QMap<int, QVariant> > >::const_iterator itB = other->mDataMap.constBegin();
-        while (itA != mDataMap.constEnd()) {
-            if ((*itA).count() != (*itB).count()){
-                //qDebug() << "AttributesModel::compare() dataMap/map have different sizes";
+        QHash<int, CellDataMap>::const_iterator itA = mCellData.constBegin();
+        for ( ; itA != mCellData.constEnd(); ++itA ) {
+            const QHash<int, CellDataMap>::const_iterator itB = other->mCellData.constFind( itA.key() );
+            if ( itB == other->mCellData.constEnd() || itA->count() != itB->count() ){
+                //qDebug() << "AttributesModel::compare() cell data have different sizes";
                 return false;
             }
-            QMap<int, QMap<int, QVariant> >::const_iterator it2A = (*itA).constBegin();
-            QMap<int, QMap<int, QVariant> >::const_iterator it2B = (*itB).constBegin();
-            while (it2A != itA->constEnd()) {
-                if ((*it2A).count() != (*it2B).count()){
-                    //qDebug() << "AttributesModel::compare() dataMap/map/map have different sizes:"
-                    //        << (*it2A).count() << (*it2B).count();
+            CellDataMap::const_iterator columnA = itA->constBegin();
+            for ( ; columnA != itA->constEnd(); ++columnA ) {
+                const CellDataMap::const_iterator columnB = itB->constFind( columnA.key() );
+                if ( columnB == itB->constEnd() || columnA->count() != columnB->count() )
                     return false;
-                }
-                QMap<int, QVariant>::const_iterator it3A = (*it2A).constBegin();
-                QMap<int, QVariant>::const_iterator it3B = (*it2B).constBegin();
-                while (it3A != it2A->constEnd()) {
-                    if ( it3A.key() != it3B.key() ){
-                        //qDebug( "AttributesModel::compare()\n"
-                        //        "   dataMap[%i, %i] values have different types.  A: %x  B: %x",
-                        //        itA.key(), it2A.key(), it3A.key(), it3B.key());
-                        return false;
-                    }
-                    if ( ! compareAttributes( it3A.key(), it3A.value(), it3B.value() ) ){
+                ColumnCellData::const_iterator it2A = columnA->constBegin();
+                for ( ; it2A != columnA->constEnd(); ++it2A ) {
+                    const ColumnCellData::const_iterator it2B = columnB->constFind( it2A.key() );
+                    if ( it2B == columnB->constEnd() ||
+                         ! compareAttributes( itA.key(), it2A.value(), it2B.value() ) ){
                         //qDebug( "AttributesModel::compare()\n"
-                        //        "   dataMap[%i, %i] values are different. Role: %x", itA.key(), it2A.key(), it3A.key());
+                        //        "   cell data [%i, %i] values are different. Role: %x",
+                        //        it2A.key(), columnA.key(), itA.key());
                         return false;
                     }
-                    ++it3A;
-                    ++it3B;
                 }
-                ++it2A;
-                ++it2B;
             }
-            ++itA;
-            ++itB;
         }
     }
     {
@@ -289,7 +278,7 @@ QVariant AttributesModel::headerData ( int section,
                                        Qt::Orientation orientation,
                                        int role/* = Qt::DisplayRole */ ) const
 {
-  if( sourceModel() ) {
+  if( sourceModel() && asksSourceModel( role ) ) {
       const QVariant sourceData = sourceModel()->headerData( section, orientation, role );
       if ( sourceData.isValid() ) return sourceData;
   }
@@ -377,6 +366,15 @@ QVariant AttributesModel::data( int role ) const
 QVariant AttributesModel::data( int column, int role ) const
 {
   if ( isKnownAttributesRole( role ) ) {
+      // This is asked for every cell without attributes of its own, so
+      // remember the result for each column
+      ColumnData* columnData = 0;
+      if ( column >= 0 ) {
+          columnData = &mColumnData[ role ];
+          if ( column < columnData->resolved.size() && columnData->resolved.at( column ) )
+              return columnData->values.at( column );
+      }
+
       // check if there is something set for the column (dataset)
       QVariant v;
       v = headerData( column, Qt::Horizontal, role );
@@ -384,6 +382,15 @@ QVariant AttributesModel::data( int column, int role ) const
       // check if there is something set at global level
       if ( !v.isValid() )
           v = data( role ); // includes automatic fallback to default
+
+      if ( columnData ) {
+          if ( column >= columnData->resolved.size() ) {
+              columnData->values.resize( column + 1 );
+              columnData->resolved.resize( column + 1 );
+          }
+          columnData->values[ column ] = v;
+          columnData->resolved[ column ] = true;
+      }
       return v;
   }
   return QVariant();
@@ -400,7 +407,7 @@ QVariant AttributesModel::data( const QModelIndex& index, int role ) const
     if( sourceModel() == 0 )
         return QVariant();
 
-    if( index.isValid() )
+    if( index.isValid() && asksSourceModel( role ) )
     {
         const QVariant sourceData = sourceModel()->data( mapToSource(index), role );
         if( sourceData.isValid() )
@@ -408,18 +415,14 @@ QVariant AttributesModel::data( const QModelIndex& index, int role ) const
     }
 
     // check if we are storing a value for this role at this cell index
-    if( mDataMap.contains( index.column() ) )
+    const QHash< int, CellDataMap >::const_iterator cells = mCellData.constFind( role );
+    if( cells != mCellData.constEnd() )
     {
-        const QMap< int,  QMap< int, QVariant > >& colDataMap = mDataMap[ index.column() ];
-        if( colDataMap.contains( index.row() ) ) 
-        {
-            const QMap< int, QVariant >& dataMap = colDataMap[ index.row() ];
-            if( dataMap.contains( role ) )
-            {
-              const QVariant v = dataMap[ role ];
-              if( v.isValid() )
-                  return v;
-            }
+        const CellDataMap::const_iterator column = cells->constFind( index.column() );
+        if( column != cells->constEnd() ) {
+            const QVariant v = column->value( index.row() );
+            if( v.isValid() )
+                return v;
         }
     }
     // check if there is something set for the column (dataset), or at global level
@@ -455,6 +458,67 @@ bool AttributesModel::isKnownAttributesRole( int role ) const
     return oneOfOurs;
 }
 
+void AttributesModel::setSourceModelAttributesRoles( const QList<int>& roles )
+{
+    mSourceModelRolesRestricted = true;
+    mSourceModelRoles = roles.toSet();
+    mColumnData.clear();
+}
+
+bool AttributesModel::asksSourceModel( int role ) const
+{
+    return !mSourceModelRolesRestricted || !isKnownAttributesRole( role ) || mSourceModelRoles.contains( role );
+}
+
+QVector<AttributesModel::Span> AttributesModel::columnSpans( int column, int role,
+                                                              const QModelIndex& parent ) const
+{
+    QVector<Span> spans;
+    const int rows = sourceModel() ? rowCount( parent ) : 0;
+    if ( rows <= 0 || column < 0 || !isKnownAttributesRole( role ) )
+        return spans;
+
+    // any cell might get its attributes from the source model, which
+    // would have to be asked for every row
+    if ( asksSourceModel( role ) )
+        return spans;
+
+    // only the cells set explicitly differ from the column's attributes
+    ColumnCellData cellData;
+    const QHash< int, CellDataMap >::const_iterator cells = mCellData.constFind( role );
+    if ( cells != mCellData.constEnd() )
+        cellData = cells->value( column );
+
+    const QVariant columnValue = data( column, role );
+    int row = 0;
+    ColumnCellData::const_iterator it = cellData.lowerBound( 0 );
+    for ( ; it != cellData.constEnd() && it.key() < rows; ++it ) {
+        if ( it.key() > row )
+            appendSpan( spans, role, row, it.key() - 1, columnValue );
+        appendSpan( spans, role, it.key(), it.key(), it.value() );
+        row = it.key() + 1;
+    }
+    if ( row < rows )
+        appendSpan( spans, role, row, rows - 1, columnValue );
+    return spans;
+}
+
+void AttributesModel::appendSpan( QVector<Span>& spans, int role,
+                                  int first, int last, const QVariant& value ) const
+{
+    if ( !spans.isEmpty() ) {
+        Span& previous = spans.last();
+        // compareAttributes() can't tell ThreeDAttributes apart
+        if ( previous.last == first - 1 && role != ThreeDAttributesRole &&
+             previous.value.isValid() == value.isValid() &&
+             ( !value.isValid() || compareAttributes( role, previous.value, value ) ) ) {
+            previous.last = last;
+            return;
+        }
+    }
+    spans.append( Span( first, last, value ) );
+}
+
 QVariant AttributesModel::defaultsForRole( int role ) const
 {
     // returns default-constructed QVariant if not found
@@ -466,10 +530,21 @@ bool AttributesModel::setData ( const QModelIndex & index, const QVariant & valu
     if ( !isKnownAttributesRole( role ) ) {
         return sourceModel()->setData( mapToSource(index), value, role );
     } else {
-        QMap< int,  QMap< int, QVariant> > &colDataMap = mDataMap[ index.column() ];
-        QMap<int, QVariant> &dataMap = colDataMap[ index.row() ];
         //qDebug() <<  "AttributesModel::setData" <<"role" << role << "value" << value;
-        dataMap.insert( role, value );
+        if ( value.isValid() ) {
+            mCellData[ role ][ index.column() ].insert( index.row(), value );
+        } else if ( mCellData.contains( role ) ) {
+            // don't let the maps grow when resetting
+            CellDataMap& cells = mCellData[ role ];
+            if ( cells.contains( index.column() ) ) {
+                ColumnCellData& columnCells = cells[ index.column() ];
+                columnCells.remove( index.row() );
+                if ( columnCells.isEmpty() )
+                    cells.remove( index.column() );
+            }
+            if ( cells.isEmpty() )
+                mCellData.remove( role );
+        }
         emit attributesChanged( index, index );
         return true;
     }
@@ -492,6 +567,8 @@ bool AttributesModel::setHeaderData ( int section, Qt::Orientation orientation,
             = orientation == Qt::Horizontal ? mHorizontalHeaderDataMap : mVerticalHeaderDataMap;
         QMap<int, QVariant> &dataMap = sectionDataMap[ section ];
         dataMap.insert( role, value );
+        if ( orientation == Qt::Horizontal )
+            mColumnData.clear();
         if( sourceModel() ){
             emit attributesChanged( index( 0, section, QModelIndex() ),
                                     index( rowCount( QModelIndex() ), section, QModelIndex() ) );
@@ -509,6 +586,7 @@ bool AttributesModel::resetHeaderData ( int section, Qt::Orientation orientation
 void AttributesModel::setPaletteType( AttributesModel::PaletteType type )
 {
     mPaletteType = type;
+    mColumnData.clear();
 }
 
 AttributesModel::PaletteType AttributesModel::paletteType() const
@@ -519,6 +597,7 @@ AttributesModel::PaletteType AttributesModel::paletteType() const
 bool KDChart::AttributesModel::setModelData( const QVariant value, int role )
 {
     mModelDataMap.insert( role, value );
+    mColumnData.clear();
     if( sourceModel() ){
         emit attributesChanged( index( 0, 0, QModelIndex() ),
                                 index( rowCount( QModelIndex() ),
@@ -576,7 +655,14 @@ void AttributesModel::setSourceModel( QAbstractItemModel* sourceModel )
                                    this, SIGNAL( modelReset() ) );
         disconnect( this->sourceModel(), SIGNAL( layoutChanged() ),
                                    this, SIGNAL( layoutChanged() ) );
+        disconnect( this->sourceModel(), SIGNAL( modelReset() ),
+                                   this, SLOT( slotInvalidateColumnData() ) );
+        disconnect( this->sourceModel(), SIGNAL( layoutChanged() ),
+                                   this, SLOT( slotInvalidateColumnData() ) );
+        disconnect( this->sourceModel(), SIGNAL( headerDataChanged( Qt::Orientation, int, int ) ),
+                                   this, SLOT( slotInvalidateColumnData() ) );
     }
+    mColumnData.clear();
     QAbstractProxyModel::setSourceModel( sourceModel );
     if( this->sourceModel() != NULL )
     {
@@ -602,6 +688,13 @@ void AttributesModel::setSourceModel( QAbstractItemModel* sourceModel )
                                 this, SIGNAL( modelReset() ) );
         connect( this->sourceModel(), SIGNAL( layoutChanged() ),
                                 this, SIGNAL( layoutChanged() ) );
+        // the column data may come from the source model's header data
+        connect( this->sourceModel(), SIGNAL( modelReset() ),
+                                this, SLOT( slotInvalidateColumnData() ) );
+        connect( this->sourceModel(), SIGNAL( layoutChanged() ),
+                                this, SLOT( slotInvalidateColumnData() ) );
+        connect( this->sourceModel(), SIGNAL( headerDataChanged( Qt::Orientation, int, int ) ),
+                                this, SLOT( slotInvalidateColumnData() ) );
     }
 }
 
@@ -628,6 +721,7 @@ void AttributesModel::slotColumnsInserted( const QModelIndex& parent, int start,
     Q_UNUSED( parent );
     Q_UNUSED( start );
     Q_UNUSED( end );
+    mColumnData.clear();
     endInsertColumns();
 }
 
@@ -654,6 +748,7 @@ void AttributesModel::slotColumnsRemoved( const QModelIndex& parent, int start,
     Q_UNUSED( parent );
     Q_UNUSED( start );
     Q_UNUSED( end );
+    mColumnData.clear();
     endRemoveColumns();
 }
 
@@ -662,10 +757,26 @@ void AttributesModel::slotDataChanged( const QModelIndex& topLeft, const QModelI
     emit dataChanged( mapFromSource( topLeft ), mapFromSource( bottomRight ) );
 }
 
+void AttributesModel::slotInvalidateColumnData()
+{
+    mColumnData.clear();
+}
+
 /** needed for serialization */
 const QMap<int, QMap<int, QMap<int, QVariant> > > AttributesModel::dataMap()const
 {
-    return mDataMap;
+    // column -> row -> role
+    QMap<int, QMap<int, QMap<int, QVariant> > > map;
+    QHash<int, CellDataMap>::const_iterator it = mCellData.constBegin();
+    for ( ; it != mCellData.constEnd(); ++it ) {
+        CellDataMap::const_iterator column = it->constBegin();
+        for ( ; column != it->constEnd(); ++column ) {
+            ColumnCellData::const_iterator cell = column->constBegin();
+            for ( ; cell != column->constEnd(); ++cell )
+                map[ column.key() ][ cell.key() ].insert( it.key(), cell.value() );
+        }
+    }
+    return map;
 }
 /** needed for serialization */
 const QMap<int, QMap<int, QVariant> > AttributesModel::horizontalHeaderDataMap()const
@@ -686,12 +797,24 @@ const QMap<int, QVariant> AttributesModel::modelDataMap()const
 /** needed for serialization */
 void AttributesModel::setDataMap( const QMap<int, QMap<int, QMap<int, QVariant> > > map )
 {
-    mDataMap = map;
+    mCellData.clear();
+    QMap<int, QMap<int, QMap<int, QVariant> > >::const_iterator column = map.constBegin();
+    for ( ; column != map.constEnd(); ++column ) {
+        QMap<int, QMap<int, QVariant> >::const_iterator row = column->constBegin();
+        for ( ; row != column->constEnd(); ++row ) {
+            QMap<int, QVariant>::const_iterator role = row->constBegin();
+            for ( ; role != row->constEnd(); ++role ) {
+                if ( role.value().isValid() )
+                    mCellData[ role.key() ][ column.key() ].insert( row.key(), role.value() );
+            }
+        }
+    }
 }
 /** needed for serialization */
 void AttributesModel::setHorizontalHeaderDataMap( const QMap<int, QMap<int, QVariant> > map )
 {
     mHorizontalHeaderDataMap = map;
+    mColumnData.clear();
 }
 /** needed for serialization */
 void AttributesModel::setVerticalHeaderDataMap( const QMap<int, QMap<int, QVariant> > map )
@@ -702,10 +825,12 @@ void AttributesModel::setVerticalHeaderDataMap( const QMap<int, QMap<int, QVaria
 void AttributesModel::setModelDataMap( const QMap<int, QVariant> map )
 {
     mModelDataMap = map;
+    mColumnData.clear();
 }
 
 void AttributesModel::setDefaultForRole( int role, const QVariant& value )
 {
+    mColumnData.clear();
     if ( value.isValid() ) {
         mDefaultsMap.insert( role, value );
     } else {
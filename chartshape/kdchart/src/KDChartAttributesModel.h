@@ -24,8 +24,12 @@
 #define __KDCHART_ATTRIBUTES_MODEL_H__
 
 #include "KDChartAbstractProxyModel.h"
+#include <QHash>
 #include <QMap>
+#include <QPair>
+#include <QSet>
 #include <QVariant>
+#include <QVector>
 
 #include "KDChartGlobal.h"
 
@@ -47,6 +51,18 @@ public:
         PaletteTypeSubdued = 2
     };
 
+    /** A run of consecutive rows sharing the same attributes value. */
+    class Span {
+    public:
+        Span() : first( 0 ), last( -1 ) {}
+        Span( int _first, int _last, const QVariant& _value )
+            : first( _first ), last( _last ), value( _value ) {}
+
+        int first;
+        int last;
+        QVariant value;
+    };
+
     explicit AttributesModel( QAbstractItemModel* model, QObject * parent = 0 );
     ~AttributesModel();
 
@@ -70,6 +86,21 @@ public:
      * internally used ones. */
     bool isKnownAttributesRole( int role ) const;
 
+    /** Declares the known attributes roles the source model provides
+     * data for. data() and headerData() don't ask the source model for
+     * any other known attributes role.
+     * By default, the source model is asked for all roles. */
+    void setSourceModelAttributesRoles( const QList<int>& roles );
+
+    /** Returns the values of the known attributes role \a role for all
+     * rows of \a column, as the value data() returns for each of them,
+     * with consecutive rows of equal values merged into one span.
+     * The spans are ordered and cover all rows of \a parent.
+     * If the source model may provide \a role, no spans are returned,
+     * since each cell would have to be asked; use data() instead. */
+    QVector<Span> columnSpans( int column, int role,
+                               const QModelIndex& parent = QModelIndex() ) const;
+
     /** Sets the palettetype used by this attributesmodel */
     void setPaletteType( PaletteType type );
     PaletteType paletteType() const;
@@ -144,16 +175,37 @@ private Q_SLOTS:
 
     void slotDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight );
 
+    void slotInvalidateColumnData();
+
 private:
     // helper
     QVariant defaultsForRole( int role ) const;
+    bool asksSourceModel( int role ) const;
+    void appendSpan( QVector<Span>& spans, int role,
+                     int first, int last, const QVariant& value ) const;
+
+    // attributes set for single cells of one column, keyed by row
+    typedef QMap< int, QVariant > ColumnCellData;
+    // attributes set for single cells, keyed by column
+    typedef QHash< int, ColumnCellData > CellDataMap;
+    // data( column, role ) of all columns, resolved on demand
+    class ColumnData {
+    public:
+        QVector<QVariant> values;
+        QVector<bool> resolved;
+    };
 
-    QMap<int, QMap<int, QMap<int, QVariant> > > mDataMap;
+    // one per role
+    QHash<int, CellDataMap> mCellData;
+    // one per role
+    mutable QHash<int, ColumnData> mColumnData;
     QMap<int, QMap<int, QVariant> > mHorizontalHeaderDataMap;
     QMap<int, QMap<int, QVariant> > mVerticalHeaderDataMap;
     QMap<int, QVariant> mModelDataMap;
     QMap<int, QVariant> mDefaultsMap;
     PaletteType mPaletteType;
+    bool mSourceModelRolesRestricted;
+    QSet<int> mSourceModelRoles;
 };
 
 }
@@ -25,6 +25,8 @@
 
 #include "KDChartBarDiagram_p.h"
 
+#include <QtCore/qmath.h>
+
 using namespace KDChart;
 
 BarDiagram::Private::Private( const Private& rhs )
@@ -54,6 +56,35 @@ void BarDiagram::BarDiagramType::paintBars( PaintContext* ctx, const QModelIndex
     //Pending Michel: configure threeDBrush settings - shadowColor etc...
     QBrush indexBrush ( diagram()->brush( index ) );
     QPen indexPen( diagram()->pen( index ) );
+
+    if ( !threeDAttrs.isEnabled() ) {
+        // flat bars are painted in batches by paintBatchedBars()
+        if ( bar.height() == 0 )
+            return;
+        reverseMapper().addRect( index.row(), index.column(), bar );
+        BarBatch& batch = batchFor( ctx, indexBrush, PrintingParameters::scalePen( indexPen ) );
+        const bool upright = m_private->orientation == Qt::Vertical;
+        if ( qAbs( upright ? bar.width() : bar.height() ) < 1.0 ) {
+            const QRectF r( bar.normalized() );
+            const int pixel = qFloor( upright ? r.center().x() : r.center().y() );
+            const qreal low = upright ? r.top() : r.left();
+            const qreal high = upright ? r.bottom() : r.right();
+            QMap< int, QPair<qreal, qreal> >::iterator column = batch.columns.find( pixel );
+            if ( column == batch.columns.end() ) {
+                batch.columns.insert( pixel, qMakePair( low, high ) );
+            } else {
+                column->first = qMin( column->first, low );
+                column->second = qMax( column->second, high );
+            }
+        } else {
+            batch.rects.append( bar );
+        }
+        return;
+    }
+
+    // keep 3D bars in front of the flat bars painted before them
+    paintBatchedBars( ctx );
+
     PainterSaver painterSaver( ctx->painter() );
     if ( diagram()->antiAliasing() )
         ctx->painter()->setRenderHint ( QPainter::Antialiasing );
@@ -157,6 +188,74 @@ void BarDiagram::BarDiagramType::paintBars( PaintContext* ctx, const QModelIndex
     //diagram()->maxDepth = threeDAttrs.depth();
 }
 
+void BarDiagram::BarDiagramType::setBarsMayOverlap( bool overlap )
+{
+    m_barsMayOverlap = overlap;
+}
+
+BarDiagram::BarDiagramType::BarBatch& BarDiagram::BarDiagramType::batchFor(
+    PaintContext* ctx, const QBrush& brush, const QPen& pen )
+{
+    // consecutive bars mostly belong to the same batch
+    if ( !m_batches.isEmpty() && m_batches.last().brush == brush && m_batches.last().pen == pen )
+        return m_batches.last();
+
+    if ( m_barsMayOverlap ) {
+        // painting the batch before a bar of another style keeps the
+        // order in which the bars overlap
+        paintBatchedBars( ctx );
+    } else {
+        // bars that can't overlap may be painted in any order
+        for ( int i = 0; i < m_batches.count(); ++i ) {
+            if ( m_batches.at( i ).brush == brush && m_batches.at( i ).pen == pen ) {
+                m_batches.move( i, m_batches.count() - 1 );
+                return m_batches.last();
+            }
+        }
+    }
+    BarBatch batch;
+    batch.brush = brush;
+    batch.pen = pen;
+    m_batches.append( batch );
+    return m_batches.last();
+}
+
+void BarDiagram::BarDiagramType::paintBatchedBars( PaintContext* ctx )
+{
+    if ( m_batches.isEmpty() )
+        return;
+
+    const PainterSaver painterSaver( ctx->painter() );
+    if ( diagram()->antiAliasing() )
+        ctx->painter()->setRenderHint ( QPainter::Antialiasing );
+    const bool upright = m_private->orientation == Qt::Vertical;
+    KDAB_FOREACH( const BarBatch& batch, m_batches ) {
+        if ( !batch.rects.isEmpty() ) {
+            ctx->painter()->setBrush( batch.brush );
+            ctx->painter()->setPen( batch.pen );
+            ctx->painter()->drawRects( batch.rects );
+        }
+        if ( !batch.columns.isEmpty() ) {
+            // at this width, a bar is mostly its outline
+            QVector<QRectF> columns;
+            columns.reserve( batch.columns.count() );
+            QMap< int, QPair<qreal, qreal> >::const_iterator it = batch.columns.constBegin();
+            for ( ; it != batch.columns.constEnd(); ++it ) {
+                const qreal length = qMax( it->second - it->first, qreal( 1.0 ) );
+                columns.append( upright ? QRectF( it.key(), it->first, 1.0, length )
+                                        : QRectF( it->first, it.key(), length, 1.0 ) );
+            }
+            ctx->painter()->setPen( Qt::NoPen );
+            if ( batch.pen.style() != Qt::NoPen )
+                ctx->painter()->setBrush( batch.pen.color() );
+            else
+                ctx->painter()->setBrush( batch.brush );
+            ctx->painter()->drawRects( columns );
+        }
+    }
+    m_batches.clear();
+}
+
 AttributesModel* BarDiagram::BarDiagramType::attributesModel() const
 {
     return m_private->attributesModel;
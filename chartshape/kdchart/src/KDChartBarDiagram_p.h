@@ -112,6 +112,7 @@ KDCHART_IMPL_DERIVED_DIAGRAM( BarDiagram, AbstractCartesianDiagram, CartesianCoo
         explicit BarDiagramType( BarDiagram* d )
             : BarDiagram::Private()
             , m_private( d->d_func() )
+            , m_barsMayOverlap( true )
         {
         }
         virtual ~BarDiagramType() {}
@@ -144,6 +145,11 @@ KDCHART_IMPL_DERIVED_DIAGRAM( BarDiagram, AbstractCartesianDiagram, CartesianCoo
 
         void paintBars( PaintContext* ctx, const QModelIndex& index,
             const QRectF& bar, double& maxDepth );
+        // paints the bars paintBars() collected, to be called when done
+        void paintBatchedBars( PaintContext* ctx );
+        // whether bars of different styles may overlap or touch, so that
+        // they have to be painted in order; true unless set otherwise
+        void setBarsMayOverlap( bool overlap );
         void calculateValueAndGapWidths( int rowCount, int colCount,
             double groupWidth,
             double& barWidth,
@@ -151,6 +157,28 @@ KDCHART_IMPL_DERIVED_DIAGRAM( BarDiagram, AbstractCartesianDiagram, CartesianCoo
             double& spaceBetweenGroups );
 
         BarDiagram::Private* m_private;
+
+    private:
+        /*
+         * Bars without 3D effects sharing a pen and a brush. If bars may
+         * overlap, a batch only holds consecutive bars and is painted when
+         * the pen or the brush changes. Bars narrower
+         * than a device pixel are merged into one pixel wide column per pixel,
+         * spanning from the lowest to the highest of them.
+         */
+        class BarBatch {
+        public:
+            QBrush brush;
+            QPen pen;
+            QVector<QRectF> rects;
+            // pixel -> ( lowest, highest ) coordinate along the value axis
+            QMap< int, QPair<qreal, qreal> > columns;
+        };
+
+        BarBatch& batchFor( PaintContext* ctx, const QBrush& brush, const QPen& pen );
+
+        QList<BarBatch> m_batches;
+        bool m_barsMayOverlap;
     };
 }
 
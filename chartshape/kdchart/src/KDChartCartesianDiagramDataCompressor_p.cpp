@@ -26,12 +26,105 @@
 #include <QAbstractItemModel>
 
 #include "KDChartAbstractCartesianDiagram.h"
+#include "KDChartAttributesModel.h"
 
 #include <KDABLibFakes>
 
 using namespace KDChart;
 using namespace std;
 
+CartesianDiagramDataCompressor::Boundaries::Boundaries()
+    : xMin( std::numeric_limits< qreal >::quiet_NaN() )
+    , xMax( std::numeric_limits< qreal >::quiet_NaN() )
+    , yMin( std::numeric_limits< qreal >::quiet_NaN() )
+    , yMax( std::numeric_limits< qreal >::quiet_NaN() )
+{
+}
+
+CartesianDiagramDataCompressor::Boundaries::Boundaries( const DataPoint& point )
+    : xMin( ISNAN( point.key ) ? 0.0 : point.key )
+    , xMax( xMin )
+    , yMin( ISNAN( point.value ) ? 0.0 : point.value )
+    , yMax( yMin )
+{
+}
+
+bool CartesianDiagramDataCompressor::Boundaries::isEmpty() const
+{
+    return ISNAN( xMin );
+}
+
+void CartesianDiagramDataCompressor::Boundaries::unite( const Boundaries& other )
+{
+    if ( other.isEmpty() )
+        return;
+    if ( isEmpty() ) {
+        *this = other;
+        return;
+    }
+    xMin = qMin( xMin, other.xMin );
+    xMax = qMax( xMax, other.xMax );
+    yMin = qMin( yMin, other.yMin );
+    yMax = qMax( yMax, other.yMax );
+}
+
+CartesianDiagramDataCompressor::BoundariesTree::BoundariesTree()
+    : size( 0 )
+    , complete( false )
+{
+}
+
+CartesianDiagramDataCompressor::StackedRow::StackedRow()
+    : valid( false )
+{
+}
+
+CartesianDiagramDataCompressor::Summary::Summary()
+    : min( 0.0 )
+    , max( 0.0 )
+    , sum( 0.0 )
+    , minRow( -1 )
+    , maxRow( -1 )
+    , count( 0 )
+    , visibleCount( 0 )
+{
+}
+
+void CartesianDiagramDataCompressor::Summary::unite( const Summary& other )
+{
+    if ( other.count > 0 ) {
+        // on ties, the first row wins
+        if ( count == 0 || other.min < min || ( other.min == min && other.minRow < minRow ) ) {
+            min = other.min;
+            minRow = other.minRow;
+        }
+        if ( count == 0 || other.max > max || ( other.max == max && other.maxRow < maxRow ) ) {
+            max = other.max;
+            maxRow = other.maxRow;
+        }
+        sum += other.sum;
+        count += other.count;
+    }
+    visibleCount += other.visibleCount;
+}
+
+CartesianDiagramDataCompressor::HiddenState::HiddenState()
+    : known( false )
+    , nothingHidden( true )
+    , hiddenCount( 0 )
+    , columnHidden( false )
+{
+}
+
+CartesianDiagramDataCompressor::KeyOrder::KeyOrder()
+    : known( false )
+    , sorted( false )
+{
+}
+
+// number of rows summarized by each block of the lowest pyramid level
+static const int PyramidBlockSize = 16;
+
 CartesianDiagramDataCompressor::CartesianDiagramDataCompressor( QObject* parent )
     : QObject( parent )
     , m_mode( Precise )
@@ -132,6 +225,10 @@ void CartesianDiagramDataCompressor::slotRowsAboutToBeInserted( const QModelInde
         return;
     Q_ASSERT( start <= end );
 
+    // the pyramids and hidden states exist independently of the cache geometry
+    invalidatePyramids();
+    invalidateHiddenStates();
+
     CachePosition startPos = mapToCache( start, 0 );
     CachePosition endPos = mapToCache( end, 0 );
 
@@ -156,6 +253,9 @@ void CartesianDiagramDataCompressor::slotRowsAboutToBeInserted( const QModelInde
         Q_ASSERT( start >= 0 && start <= m_data[ i ].size() );
         m_data[ i ].insert( start, end - start + 1, DataPoint() );
     }
+    if( start <= m_stackedRows.size() )
+        m_stackedRows.insert( start, end - start + 1, StackedRow() );
+    invalidateBoundaries();
 }
 
 void CartesianDiagramDataCompressor::slotRowsInserted( const QModelIndex& parent, int start, int end )
@@ -184,10 +284,11 @@ void CartesianDiagramDataCompressor::slotRowsInserted( const QModelIndex& parent
     start = startPos.first;
     end = endPos.first;
 
+    // Retrieved again on demand
     for( int i = 0; i < m_data.size(); ++i )
     {
         for( int j = start; j < m_data[i].size(); ++j ) {
-            retrieveModelData( CachePosition( j, i ) );
+            invalidate( CachePosition( j, i ) );
         }
     }
 }
@@ -217,9 +318,16 @@ void CartesianDiagramDataCompressor::slotColumnsAboutToBeInserted( const QModelI
     start = startPos.second;
     end = endPos.second;
 
-    const int rowCount = qMin( m_model ? m_model->rowCount( m_rootIndex ) : 0, m_xResolution );
+    const int rowCount = cacheRowCount();
     Q_ASSERT( start >= 0 && start <= m_data.size() );
     m_data.insert( start, end - start + 1, QVector< DataPoint >( rowCount ) );
+    if( start <= m_boundaries.size() )
+        m_boundaries.insert( start, end - start + 1, BoundariesTree() );
+    if( start <= m_pyramids.size() )
+        m_pyramids.insert( start, end - start + 1, Pyramid() );
+    invalidateStackedRows();
+    invalidateHiddenStates();
+    invalidateKeyOrders();
 }
 
 void CartesianDiagramDataCompressor::slotColumnsInserted( const QModelIndex& parent, int start, int end )
@@ -248,10 +356,11 @@ void CartesianDiagramDataCompressor::slotColumnsInserted( const QModelIndex& par
     start = startPos.second;
     end = endPos.second;
 
+    // Retrieved again on demand
     for( int i = start; i < m_data.size(); ++i )
     {
         for(int j = 0; j < m_data[i].size(); ++j ) {
-            retrieveModelData( CachePosition( j, i ) );
+            invalidate( CachePosition( j, i ) );
         }
     }
 }
@@ -262,6 +371,10 @@ void CartesianDiagramDataCompressor::slotRowsAboutToBeRemoved( const QModelIndex
         return;
     Q_ASSERT( start <= end );
 
+    // the pyramids and hidden states exist independently of the cache geometry
+    invalidatePyramids();
+    invalidateHiddenStates();
+
     CachePosition startPos = mapToCache( start, 0 );
     CachePosition endPos = mapToCache( end, 0 );
 
@@ -285,6 +398,9 @@ void CartesianDiagramDataCompressor::slotRowsAboutToBeRemoved( const QModelIndex
     {
         m_data[ i ].remove( start, end - start + 1 );
     }
+    if( start < m_stackedRows.size() )
+        m_stackedRows.remove( start, qMin( end - start + 1, m_stackedRows.size() - start ) );
+    invalidateBoundaries();
 }
 
 void CartesianDiagramDataCompressor::slotRowsRemoved( const QModelIndex& parent, int start, int end )
@@ -307,9 +423,33 @@ void CartesianDiagramDataCompressor::slotRowsRemoved( const QModelIndex& parent,
         return;
     }
 
+    // Dropping the first rows of an uncompressed cache, as a sliding window
+    // over streamed data does, doesn't change the remaining data points.
+    // Only their indexes moved, so rebase them instead of fetching all the
+    // data again.
+    if( start == 0 && m_data[0].size() == m_model->rowCount( m_rootIndex ) )
+    {
+        const int removed = end - start + 1;
+        for( int i = 0; i < m_data.size(); ++i ) {
+            for( int j = 0; j < m_data[i].size(); ++j ) {
+                DataPoint& point = m_data[i][j];
+                if( !point.index.isValid() )
+                    continue;
+                point.index = m_model->index( point.index.row() - removed, point.index.column(), m_rootIndex );
+                // Without x values, the key is the row
+                if( m_datasetDimension == 1 )
+                    point.key = point.index.row();
+            }
+        }
+        // Keyed by cache position, which now refers to other rows
+        m_dataValueAttributesCache.clear();
+        return;
+    }
+
+    // Retrieved again on demand
     for( int i = 0; i < m_data.size(); ++i ) {
         for(int j = start; j < m_data[i].size(); ++j ) {
-            retrieveModelData( CachePosition( j, i ) );
+            invalidate( CachePosition( j, i ) );
         }
     }
 }
@@ -340,6 +480,13 @@ void CartesianDiagramDataCompressor::slotColumnsAboutToBeRemoved( const QModelIn
     end = endPos.second;
 
     m_data.remove( start, end - start + 1 );
+    if( start < m_boundaries.size() )
+        m_boundaries.remove( start, qMin( end - start + 1, m_boundaries.size() - start ) );
+    if( start < m_pyramids.size() )
+        m_pyramids.remove( start, qMin( end - start + 1, m_pyramids.size() - start ) );
+    invalidateStackedRows();
+    invalidateHiddenStates();
+    invalidateKeyOrders();
 }
 
 void CartesianDiagramDataCompressor::slotColumnsRemoved( const QModelIndex& parent, int start, int end )
@@ -362,9 +509,10 @@ void CartesianDiagramDataCompressor::slotColumnsRemoved( const QModelIndex& pare
         return;
     }
 
+    // Retrieved again on demand
     for( int i = start; i < m_data.size(); ++i ) {
         for( int j = 0; j < m_data[i].size(); ++j ) {
-            retrieveModelData( CachePosition( j, i ) );
+            invalidate( CachePosition( j, i ) );
         }
     }
 }
@@ -389,19 +537,92 @@ void CartesianDiagramDataCompressor::slotModelDataChanged(
     Q_ASSERT( topLeftIndex.parent() == bottomRightIndex.parent() );
     Q_ASSERT( topLeftIndex.row() <= bottomRightIndex.row() );
     Q_ASSERT( topLeftIndex.column() <= bottomRightIndex.column() );
+    // DataHiddenRole may have changed along with the data
+    for ( int column = topLeftIndex.column(); column <= bottomRightIndex.column(); ++column )
+        updateHiddenRows( column, topLeftIndex.row(), bottomRightIndex.row() );
     CachePosition topleft = mapToCache( topLeftIndex );
     CachePosition bottomright = mapToCache( bottomRightIndex );
+    // A data point may also have been selected for, or have influenced the
+    // selection of, a neighbor
+    if( m_datasetDimension == 1 && topleft.first >= 0 ) {
+        if( m_mode == MinMax || m_mode == FirstLast ) {
+            topleft.first -= topleft.first % 2;
+            bottomright.first = qMin( bottomright.first + 1 - bottomright.first % 2, m_data[0].size() - 1 );
+        } else if( m_mode == LargestTriangleThreeBuckets ) {
+            topleft.first = qMax( 0, topleft.first - 1 );
+            bottomright.first = m_data[0].size() - 1;
+        }
+    }
     for ( int row = topleft.first; row <= bottomright.first; ++row )
         for ( int column = topleft.second; column <= bottomright.second; ++column )
             invalidate( CachePosition( row, column ) );
+    if ( m_datasetDimension == 1 ) {
+        for ( int column = topLeftIndex.column(); column <= bottomRightIndex.column(); ++column )
+            updatePyramid( column, topLeftIndex.row(), bottomRightIndex.row() );
+    }
+}
+
+void CartesianDiagramDataCompressor::slotModelAttributesChanged(
+    const QModelIndex& topLeftIndex,
+    const QModelIndex& bottomRightIndex )
+{
+    if ( !topLeftIndex.isValid() || topLeftIndex.parent() != m_rootIndex )
+        return;
+    if ( bottomRightIndex.isValid() ) {
+        slotModelDataChanged( topLeftIndex, bottomRightIndex );
+        return;
+    }
+
+    // Header and model wide attributes are signalled with a bottom right
+    // index past the last row, which is invalid. Only the columns whose
+    // DataHiddenRole changed need to be read again.
+    const AttributesModel* const attributes = qobject_cast< AttributesModel* >( m_model );
+    Q_ASSERT( attributes );
+    for ( int column = 0; column < m_hiddenStates.size(); ++column ) {
+        const HiddenState& state = m_hiddenStates[ column ];
+        if ( state.known && state.columnHidden != qVariantValue<bool>( attributes->data( column, DataHiddenRole ) ) )
+            invalidateColumn( column );
+    }
+
+    // The cached data value attributes of the section, or of all columns
+    // if this was a model wide change, which also starts at column 0
+    const int cacheColumn = topLeftIndex.column() / m_datasetDimension;
+    if ( cacheColumn == 0 ) {
+        m_dataValueAttributesCache.clear();
+    } else {
+        DataValueAttributesCache::iterator it = m_dataValueAttributesCache.begin();
+        while ( it != m_dataValueAttributesCache.end() ) {
+            if ( it.key().second == cacheColumn )
+                it = m_dataValueAttributesCache.erase( it );
+            else
+                ++it;
+        }
+    }
 }
 
 void CartesianDiagramDataCompressor::slotModelLayoutChanged()
 {
+    invalidatePyramids();
+    invalidateHiddenStates();
     rebuildCache();
     calculateSampleStepWidth();
 }
 
+void CartesianDiagramDataCompressor::slotModelReset()
+{
+    invalidatePyramids();
+    invalidateHiddenStates();
+    rebuildCache();
+}
+
+void CartesianDiagramDataCompressor::slotDiagramDataHidden()
+{
+    // The pyramids and the cached data points know about hidden rows, too
+    invalidateHiddenStates();
+    invalidatePyramids();
+    clearCache();
+}
+
 void CartesianDiagramDataCompressor::slotDiagramLayoutChanged( AbstractDiagram* diagramBase )
 {
     AbstractCartesianDiagram* diagram = qobject_cast< AbstractCartesianDiagram* >( diagramBase );
@@ -447,6 +668,9 @@ void CartesianDiagramDataCompressor::setModel( QAbstractItemModel* model )
                  this, SLOT( slotModelHeaderDataChanged( Qt::Orientation, int, int ) ) );
         disconnect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ),
                  this, SLOT( slotModelDataChanged( QModelIndex, QModelIndex ) ) );
+        if ( qobject_cast< AttributesModel* >( m_model ) )
+            disconnect( m_model, SIGNAL( attributesChanged( QModelIndex, QModelIndex ) ),
+                        this, SLOT( slotModelAttributesChanged( QModelIndex, QModelIndex ) ) );
         disconnect( m_model, SIGNAL( layoutChanged() ),
                  this, SLOT( slotModelLayoutChanged() ) );
         disconnect( m_model, SIGNAL( rowsAboutToBeInserted( QModelIndex, int, int ) ),
@@ -466,7 +690,7 @@ void CartesianDiagramDataCompressor::setModel( QAbstractItemModel* model )
         disconnect( m_model, SIGNAL( columnsAboutToBeRemoved( QModelIndex, int, int ) ),
                  this, SLOT( slotColumnsAboutToBeRemoved( QModelIndex, int, int ) ) );
         disconnect( m_model, SIGNAL( modelReset() ),
-                    this, SLOT( rebuildCache() ) );
+                    this, SLOT( slotModelReset() ) );
         m_model = 0;
     }
 
@@ -478,6 +702,10 @@ void CartesianDiagramDataCompressor::setModel( QAbstractItemModel* model )
                  SLOT( slotModelHeaderDataChanged( Qt::Orientation, int, int ) ) );
         connect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ),
                  SLOT( slotModelDataChanged( QModelIndex, QModelIndex ) ) );
+        // DataHiddenRole is an attribute, it never shows up in dataChanged()
+        if ( qobject_cast< AttributesModel* >( m_model ) )
+            connect( m_model, SIGNAL( attributesChanged( QModelIndex, QModelIndex ) ),
+                     SLOT( slotModelAttributesChanged( QModelIndex, QModelIndex ) ) );
         connect( m_model, SIGNAL( layoutChanged() ),
                  SLOT( slotModelLayoutChanged() ) );
         connect( m_model, SIGNAL( rowsAboutToBeInserted( QModelIndex, int, int ) ),
@@ -497,8 +725,10 @@ void CartesianDiagramDataCompressor::setModel( QAbstractItemModel* model )
         connect( m_model, SIGNAL( columnsAboutToBeRemoved( QModelIndex, int, int ) ),
                  SLOT( slotColumnsAboutToBeRemoved( QModelIndex, int, int ) ) );
         connect( m_model, SIGNAL( modelReset() ),
-                    this, SLOT( rebuildCache() ) );
+                    this, SLOT( slotModelReset() ) );
     }
+    invalidatePyramids();
+    invalidateHiddenStates();
     rebuildCache();
     calculateSampleStepWidth();
 }
@@ -509,6 +739,8 @@ void CartesianDiagramDataCompressor::setRootIndex( const QModelIndex& root )
         Q_ASSERT( root.model() == m_model || !root.isValid() );
         m_rootIndex = root;
         m_modelCache.setRootIndex( root );
+        invalidatePyramids();
+        invalidateHiddenStates();
         rebuildCache();
         calculateSampleStepWidth();
     }
@@ -542,6 +774,8 @@ void CartesianDiagramDataCompressor::clearCache()
 {
     for ( int column = 0; column < m_data.size(); ++column )
         m_data[column].fill( DataPoint() );
+    invalidateBoundaries();
+    invalidateStackedRows();
 }
 
 void CartesianDiagramDataCompressor::rebuildCache() const
@@ -550,13 +784,16 @@ void CartesianDiagramDataCompressor::rebuildCache() const
 
     m_data.clear();
     const int columnCount = m_model ? m_model->columnCount( m_rootIndex ) / m_datasetDimension : 0;
-    const int rowCount = qMin( m_model ? m_model->rowCount( m_rootIndex ) : 0, m_xResolution );
+    const int rowCount = cacheRowCount();
     m_data.resize( columnCount );
     for ( int i = 0; i < columnCount; ++i ) {
         m_data[i].resize( rowCount );
     }
     // also empty the attrs cache
     m_dataValueAttributesCache.clear();
+    m_boundaries.clear();
+    m_stackedRows.clear();
+    m_keyOrders.clear();
 }
 
 const CartesianDiagramDataCompressor::DataPoint& CartesianDiagramDataCompressor::data( const CachePosition& position ) const
@@ -570,56 +807,209 @@ const CartesianDiagramDataCompressor::DataPoint& CartesianDiagramDataCompressor:
 QPair< QPointF, QPointF > CartesianDiagramDataCompressor::dataBoundaries() const
 {
     const int colCount = modelDataColumns();
-    double xMin = std::numeric_limits< double >::quiet_NaN();
-    double xMax = std::numeric_limits< double >::quiet_NaN();
-    double yMin = std::numeric_limits< double >::quiet_NaN();
-    double yMax = std::numeric_limits< double >::quiet_NaN();
-
+    Boundaries boundaries;
     for( int column = 0; column < colCount; ++column )
-    {
-        const DataPointVector& data = m_data[ column ];
-        int row = 0;
-        for( DataPointVector::const_iterator it = data.begin(); it != data.end(); ++it, ++row )
-        {
-            const DataPoint& p = *it;
-            if( !p.index.isValid() )
-                retrieveModelData( CachePosition( row, column ) );
+        boundaries.unite( columnBoundaries( column ) );
 
-            const double valueX = ISNAN( p.key ) ? 0.0 : p.key;
-            const double valueY = ISNAN( p.value ) ? 0.0 : p.value;
-            if( ISNAN( xMin ) )
-            {
-                xMin = valueX;
-                xMax = valueX;
-                yMin = valueY;
-                yMax = valueY;
+    // NOTE: calculateDataBoundaries must return the *real* data boundaries!
+    //       i.e. we may NOT fake yMin to be qMin( 0.0, yMin )
+    //       (khz, 2008-01-24)
+    const QPointF bottomLeft( QPointF( boundaries.xMin, boundaries.yMin ) );
+    const QPointF topRight( QPointF( boundaries.xMax, boundaries.yMax ) );
+    return QPair< QPointF, QPointF >( bottomLeft, topRight );
+}
+
+CartesianDiagramDataCompressor::Boundaries CartesianDiagramDataCompressor::columnBoundaries( int column ) const
+{
+    if( m_boundaries.size() != m_data.size() )
+        m_boundaries.resize( m_data.size() );
+
+    BoundariesTree& tree = m_boundaries[ column ];
+    const DataPointVector& data = m_data[ column ];
+    const int size = data.size();
+    if( size == 0 )
+        return Boundaries();
+
+    if( !tree.complete || tree.size != size ) {
+        tree.size = size;
+        tree.nodes.resize( 2 * size );
+        tree.dirtyRows.clear();
+        tree.isDirty.fill( false, size );
+        for( int row = 0; row < size; ++row ) {
+            if( !data[ row ].index.isValid() )
+                retrieveModelData( CachePosition( row, column ) );
+            tree.nodes[ size + row ] = Boundaries( data[ row ] );
+        }
+        for( int node = size - 1; node > 0; --node ) {
+            tree.nodes[ node ] = tree.nodes[ 2 * node ];
+            tree.nodes[ node ].unite( tree.nodes[ 2 * node + 1 ] );
+        }
+        tree.complete = true;
+    } else {
+        Q_FOREACH( int row, tree.dirtyRows ) {
+            if( !data[ row ].index.isValid() )
+                retrieveModelData( CachePosition( row, column ) );
+            tree.nodes[ size + row ] = Boundaries( data[ row ] );
+            tree.isDirty[ row ] = false;
+            for( int node = ( size + row ) / 2; node > 0; node /= 2 ) {
+                tree.nodes[ node ] = tree.nodes[ 2 * node ];
+                tree.nodes[ node ].unite( tree.nodes[ 2 * node + 1 ] );
             }
-            else
-            {
-                xMin = qMin( xMin, valueX );
-                xMax = qMax( xMax, valueX );
-                yMin = qMin( yMin, valueY );
-                yMax = qMax( yMax, valueY );
+        }
+        tree.dirtyRows.clear();
+    }
+
+    // With a single leaf, node 1 is that leaf
+    return tree.nodes[ 1 ];
+}
+
+void CartesianDiagramDataCompressor::invalidateBoundaries()
+{
+    for( int column = 0; column < m_boundaries.size(); ++column )
+        m_boundaries[ column ].complete = false;
+}
+
+qreal CartesianDiagramDataCompressor::stackedValue( int row, int column, StackedValueType type ) const
+{
+    if ( ! isValidCachePosition( CachePosition( row, column ) ) )
+        return 0.0;
+    return stackedRow( row ).sums[ column * StackedValueTypeCount + type ];
+}
+
+qreal CartesianDiagramDataCompressor::stackedTotal( int row, StackedValueType type ) const
+{
+    return stackedValue( row, modelDataColumns() - 1, type );
+}
+
+bool CartesianDiagramDataCompressor::isSortedByKey( int column ) const
+{
+    // Without x values the keys are the (averaged) rows
+    if( m_datasetDimension == 1 )
+        return true;
+
+    const int columnCount = modelDataColumns();
+    if( column < 0 || column >= columnCount )
+        return false;
+    if( m_keyOrders.size() != columnCount ) {
+        m_keyOrders.clear();
+        m_keyOrders.resize( columnCount );
+    }
+
+    KeyOrder& order = m_keyOrders[ column ];
+    if( !order.known ) {
+        const int rowCount = m_data[ column ].size();
+        order.sorted = true;
+        qreal previousKey = -std::numeric_limits< qreal >::infinity();
+        for( int row = 0; row < rowCount && order.sorted; ++row ) {
+            const qreal key = data( CachePosition( row, column ) ).key;
+            // a missing x value can't be searched for
+            order.sorted = !ISNAN( key ) && key >= previousKey;
+            previousKey = key;
+        }
+        order.known = true;
+    }
+    return order.sorted;
+}
+
+void CartesianDiagramDataCompressor::rowsInKeyRange( int column, qreal minKey, qreal maxKey, int* first, int* last ) const
+{
+    Q_ASSERT( isSortedByKey( column ) );
+    const int rowCount = modelDataRows();
+
+    // first row with a key >= minKey
+    int low = 0;
+    int high = rowCount;
+    while( low < high ) {
+        const int middle = low + ( high - low ) / 2;
+        if( data( CachePosition( middle, column ) ).key < minKey )
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    *first = low;
+
+    // first row with a key > maxKey
+    high = rowCount;
+    while( low < high ) {
+        const int middle = low + ( high - low ) / 2;
+        if( data( CachePosition( middle, column ) ).key <= maxKey )
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    *last = low - 1;
+
+    // The segments leaving the range end at the neighbors with a value,
+    // missing values in between may be bridged
+    do {
+        --*first;
+    } while( *first > 0 && ISNAN( data( CachePosition( *first, column ) ).value ) );
+    do {
+        ++*last;
+    } while( *last < rowCount - 1 && ISNAN( data( CachePosition( *last, column ) ).value ) );
+    *first = qMax( *first, 0 );
+    *last = qMin( *last, rowCount - 1 );
+}
+
+const CartesianDiagramDataCompressor::StackedRow& CartesianDiagramDataCompressor::stackedRow( int row ) const
+{
+    const int rowCount = m_data.first().size();
+    if( m_stackedRows.size() != rowCount ) {
+        m_stackedRows.clear();
+        m_stackedRows.resize( rowCount );
+    }
+
+    StackedRow& stack = m_stackedRows[ row ];
+    if( !stack.valid ) {
+        const int columnCount = m_data.size();
+        stack.sums.resize( columnCount * StackedValueTypeCount );
+        qreal positive = 0.0;
+        qreal negative = 0.0;
+        qreal absolute = 0.0;
+        qreal missing = 0.0;
+        for( int column = 0; column < columnCount; ++column ) {
+            const qreal value = data( CachePosition( row, column ) ).value;
+            if( ISNAN( value ) ) {
+                missing += 1.0;
+            } else if( value > 0.0 ) {
+                positive += value;
+                absolute += value;
+            } else if( value < 0.0 ) {
+                negative += value;
+                absolute -= value;
             }
+            qreal* sums = stack.sums.data() + column * StackedValueTypeCount;
+            sums[ PositiveValues ] = positive;
+            sums[ NegativeValues ] = negative;
+            sums[ AbsoluteValues ] = absolute;
+            sums[ MissingValues ] = missing;
         }
+        stack.valid = true;
     }
+    return stack;
+}
 
-    // NOTE: calculateDataBoundaries must return the *real* data boundaries!
-    //       i.e. we may NOT fake yMin to be qMin( 0.0, yMin )
-    //       (khz, 2008-01-24)
-    const QPointF bottomLeft( QPointF( xMin, yMin ) );
-    const QPointF topRight( QPointF( xMax, yMax ) );
-    return QPair< QPointF, QPointF >( bottomLeft, topRight );
+void CartesianDiagramDataCompressor::invalidateStackedRows()
+{
+    m_stackedRows.clear();
 }
-        
+
 void CartesianDiagramDataCompressor::retrieveModelData( const CachePosition& position ) const
 {
     Q_ASSERT( isValidCachePosition( position ) );
     DataPoint result;
 
-    switch(m_mode ) {
+    // Approximations only make a difference if several data points share a
+    // cache position, which never happens with x/y data sets
+    const ApproximationMode mode = ( m_datasetDimension != 1 || indexesPerPixel() <= 1.0 ) ? Precise : m_mode;
+
+    switch( mode ) {
     case Precise:
     {
+        if( m_datasetDimension == 1 && indexesPerPixel() > 1.0 ) {
+            result = summarizedDataPoint( position );
+            break;
+        }
         bool forceHidden = false;
         result.hidden = true;
         const QModelIndexList indexes = mapToModel( position );
@@ -684,24 +1074,387 @@ void CartesianDiagramDataCompressor::retrieveModelData( const CachePosition& pos
         Q_FOREACH( const QModelIndex& index, indexes )
         {
             // the point is visible if any of the points at this pixel position is visible
-            if ( qVariantValue<bool>( m_model->data( index, DataHiddenRole ) ) == false ) {
+            if ( !isHiddenRow( index.row(), index.column() ) ) {
                 result.hidden = false;
+                break;
             }
         }
         }
     }
     break;
     case SamplingSeven:
-    default:
-    {
-    }
-    break;
+        result = sampledDataPoint( position );
+        break;
+    case MinMax:
+    case FirstLast:
+        retrieveSelectedDataPoints( position );
+        return;
+    case LargestTriangleThreeBuckets:
+        retrieveLargestTriangleThreeBuckets( position.second );
+        return;
     };
 
     m_data[position.second][position.first] = result;
     Q_ASSERT( isCached( position ) );
 }
 
+CartesianDiagramDataCompressor::DataPoint CartesianDiagramDataCompressor::modelDataPoint( int row, int column ) const
+{
+    DataPoint result;
+    result.index = m_model->index( row, column, m_rootIndex );
+    result.key = row;
+    result.value = m_modelCache.data( result.index );
+    result.hidden = isHiddenRow( row, column );
+    return result;
+}
+
+CartesianDiagramDataCompressor::DataPoint CartesianDiagramDataCompressor::summarizedDataPoint(
+        const CachePosition& position ) const
+{
+    // The rows mapToModel() would return, without creating all their indexes
+    const qreal ipp = indexesPerPixel();
+    const int rowsPerPixel = static_cast< int >( ipp ) + ( ipp > static_cast< int >( ipp ) ? 1 : 0 );
+    const int first = qRound( position.first * ipp );
+    const int last = qMin( first + rowsPerPixel - 1, m_model->rowCount( m_rootIndex ) - 1 );
+
+    DataPoint result;
+    result.hidden = true;
+    if( first > last )
+        return result;
+
+    const Summary summary = summarize( position.second, first, last );
+    result.index = m_model->index( first, position.second, m_rootIndex );
+    result.key = ( first + last ) / 2.0;
+    // rows without a value count as zero
+    if( summary.count > 0 )
+        result.value = summary.sum / ( last - first + 1 );
+    // the point is visible if any of the points at this pixel position is visible
+    result.hidden = summary.visibleCount == 0;
+    return result;
+}
+
+CartesianDiagramDataCompressor::Summary CartesianDiagramDataCompressor::rowSummary( int row, int column ) const
+{
+    Summary result;
+    const QModelIndex index = m_model->index( row, column, m_rootIndex );
+    const qreal value = m_modelCache.data( index );
+    if( !ISNAN( value ) ) {
+        result.min = result.max = result.sum = value;
+        result.minRow = result.maxRow = row;
+        result.count = 1;
+    }
+    if( !isHiddenRow( row, column ) )
+        result.visibleCount = 1;
+    return result;
+}
+
+CartesianDiagramDataCompressor::Summary CartesianDiagramDataCompressor::summarize( int column, int first, int last ) const
+{
+    if( m_pyramids.size() != m_data.size() )
+        m_pyramids.resize( m_data.size() );
+    if( m_pyramids[ column ].levels.isEmpty() )
+        buildPyramid( column );
+    const Pyramid& pyramid = m_pyramids[ column ];
+
+    // Only whole blocks are taken from the pyramid, the rows around them
+    // are read one by one
+    Summary result;
+    int firstBlock = ( first + PyramidBlockSize - 1 ) / PyramidBlockSize;
+    int lastBlock = ( last + 1 ) / PyramidBlockSize - 1;
+    if( firstBlock > lastBlock ) {
+        for( int row = first; row <= last; ++row )
+            result.unite( rowSummary( row, column ) );
+        return result;
+    }
+    for( int row = first; row < firstBlock * PyramidBlockSize; ++row )
+        result.unite( rowSummary( row, column ) );
+    for( int row = ( lastBlock + 1 ) * PyramidBlockSize; row <= last; ++row )
+        result.unite( rowSummary( row, column ) );
+
+    // Take the blocks that aren't paired with their neighbor from each
+    // level, and the others from the levels above
+    for( int level = 0; firstBlock <= lastBlock; ++level ) {
+        const QVector< Summary >& blocks = pyramid.levels[ level ];
+        if( firstBlock % 2 == 1 )
+            result.unite( blocks[ firstBlock++ ] );
+        if( firstBlock <= lastBlock && lastBlock % 2 == 0 )
+            result.unite( blocks[ lastBlock-- ] );
+        firstBlock /= 2;
+        lastBlock = lastBlock < firstBlock * 2 ? -1 : lastBlock / 2;
+    }
+    return result;
+}
+
+void CartesianDiagramDataCompressor::buildPyramid( int column ) const
+{
+    Pyramid& pyramid = m_pyramids[ column ];
+    pyramid.levels.clear();
+
+    const int rowCount = m_model->rowCount( m_rootIndex );
+    m_modelCache.fillColumn( column );
+    QVector< Summary > blocks( ( rowCount + PyramidBlockSize - 1 ) / PyramidBlockSize );
+    for( int row = 0; row < rowCount; ++row )
+        blocks[ row / PyramidBlockSize ].unite( rowSummary( row, column ) );
+    pyramid.levels.append( blocks );
+
+    while( pyramid.levels.last().size() > 1 ) {
+        const QVector< Summary > below = pyramid.levels.last();
+        QVector< Summary > level( ( below.size() + 1 ) / 2 );
+        for( int i = 0; i < below.size(); ++i )
+            level[ i / 2 ].unite( below[ i ] );
+        pyramid.levels.append( level );
+    }
+}
+
+void CartesianDiagramDataCompressor::updatePyramid( int column, int first, int last )
+{
+    if( column < 0 || column >= m_pyramids.size() || m_pyramids[ column ].levels.isEmpty() )
+        return;
+    Pyramid& pyramid = m_pyramids[ column ];
+
+    // Rebuilding is cheaper than updating most of the pyramid
+    const int rowCount = m_model->rowCount( m_rootIndex );
+    if( 2 * ( last - first + 1 ) > rowCount ) {
+        pyramid.levels.clear();
+        return;
+    }
+
+    int firstBlock = first / PyramidBlockSize;
+    int lastBlock = qMin( last / PyramidBlockSize, pyramid.levels[ 0 ].size() - 1 );
+    for( int block = firstBlock; block <= lastBlock; ++block ) {
+        Summary summary;
+        const int end = qMin( ( block + 1 ) * PyramidBlockSize, rowCount );
+        for( int row = block * PyramidBlockSize; row < end; ++row )
+            summary.unite( rowSummary( row, column ) );
+        pyramid.levels[ 0 ][ block ] = summary;
+    }
+
+    for( int level = 1; level < pyramid.levels.size(); ++level ) {
+        firstBlock /= 2;
+        lastBlock /= 2;
+        const QVector< Summary >& below = pyramid.levels[ level - 1 ];
+        for( int block = firstBlock; block <= lastBlock; ++block ) {
+            Summary summary = below[ 2 * block ];
+            if( 2 * block + 1 < below.size() )
+                summary.unite( below[ 2 * block + 1 ] );
+            pyramid.levels[ level ][ block ] = summary;
+        }
+    }
+}
+
+void CartesianDiagramDataCompressor::invalidatePyramids()
+{
+    m_pyramids.clear();
+}
+
+bool CartesianDiagramDataCompressor::isHiddenRow( int row, int column ) const
+{
+    const HiddenState& state = hiddenState( column );
+    if( state.nothingHidden )
+        return false;
+    // rows added without notifying us
+    if( row >= state.hidden.size() )
+        return qVariantValue<bool>( m_model->data( m_model->index( row, column, m_rootIndex ), DataHiddenRole ) );
+    return state.hidden.testBit( row );
+}
+
+const CartesianDiagramDataCompressor::HiddenState& CartesianDiagramDataCompressor::hiddenState( int column ) const
+{
+    const int columnCount = m_model->columnCount( m_rootIndex );
+    if( m_hiddenStates.size() != columnCount ) {
+        m_hiddenStates.clear();
+        m_hiddenStates.resize( columnCount );
+    }
+
+    // Most of the time nothing is hidden at all, and the bits are never
+    // looked at. Asking the attributes model for each row is expensive.
+    HiddenState& state = m_hiddenStates[ column ];
+    if( !state.known ) {
+        const int rowCount = m_model->rowCount( m_rootIndex );
+        state.hidden.fill( false, rowCount );
+        state.hiddenCount = 0;
+        for( int row = 0; row < rowCount; ++row ) {
+            if( qVariantValue<bool>( m_model->data( m_model->index( row, column, m_rootIndex ), DataHiddenRole ) ) ) {
+                state.hidden.setBit( row );
+                ++state.hiddenCount;
+            }
+        }
+        state.nothingHidden = state.hiddenCount == 0;
+        const AttributesModel* const attributes = qobject_cast< AttributesModel* >( m_model );
+        state.columnHidden = attributes && qVariantValue<bool>( attributes->data( column, DataHiddenRole ) );
+        state.known = true;
+    }
+    return state;
+}
+
+void CartesianDiagramDataCompressor::updateHiddenRows( int column, int first, int last )
+{
+    if( column < 0 || column >= m_hiddenStates.size() || !m_hiddenStates[ column ].known )
+        return;
+    HiddenState& state = m_hiddenStates[ column ];
+    // rows beyond the bits are read by isHiddenRow() directly
+    last = qMin( last, state.hidden.size() - 1 );
+    for( int row = first; row <= last; ++row ) {
+        const bool hidden = qVariantValue<bool>( m_model->data( m_model->index( row, column, m_rootIndex ), DataHiddenRole ) );
+        if( hidden != state.hidden.testBit( row ) ) {
+            state.hidden.setBit( row, hidden );
+            state.hiddenCount += hidden ? 1 : -1;
+        }
+    }
+    state.nothingHidden = state.hiddenCount == 0;
+}
+
+void CartesianDiagramDataCompressor::invalidateHiddenStates()
+{
+    m_hiddenStates.clear();
+}
+
+void CartesianDiagramDataCompressor::invalidateColumn( int column )
+{
+    if( column < m_hiddenStates.size() )
+        m_hiddenStates[ column ].known = false;
+    const int cacheColumn = column / m_datasetDimension;
+    if( cacheColumn >= m_data.size() )
+        return;
+    m_data[ cacheColumn ].fill( DataPoint() );
+    if( cacheColumn < m_boundaries.size() )
+        m_boundaries[ cacheColumn ].complete = false;
+    if( cacheColumn < m_pyramids.size() )
+        m_pyramids[ cacheColumn ].levels.clear();
+    if( cacheColumn < m_keyOrders.size() )
+        m_keyOrders[ cacheColumn ].known = false;
+    invalidateStackedRows();
+}
+
+void CartesianDiagramDataCompressor::invalidateKeyOrders()
+{
+    m_keyOrders.clear();
+}
+
+CartesianDiagramDataCompressor::DataPoint CartesianDiagramDataCompressor::sampledDataPoint(
+        const CachePosition& position ) const
+{
+    int first, last;
+    mapToModelRows( position.first, &first, &last );
+
+    // Only every m_sampleStep-th row is read, so the cost per pixel doesn't
+    // grow with the number of rows
+    const int step = qMax( 1, static_cast< int >( m_sampleStep ) );
+    DataPoint result;
+    result.hidden = true;
+    result.key = 0.0;
+    double sum = 0.0;
+    int samples = 0;
+    int values = 0;
+    for( int row = first; row <= last; row += step, ++samples ) {
+        const DataPoint sample = modelDataPoint( row, position.second );
+        if( samples == 0 )
+            result.index = sample.index;
+        if( !ISNAN( sample.value ) ) {
+            sum += sample.value;
+            ++values;
+        }
+        // the point is visible if any of the samples is visible
+        if( !sample.hidden )
+            result.hidden = false;
+        result.key += row;
+    }
+    result.key /= samples;
+    if( values > 0 )
+        result.value = sum / values;
+    return result;
+}
+
+void CartesianDiagramDataCompressor::retrieveSelectedDataPoints( const CachePosition& position ) const
+{
+    DataPointVector& data = m_data[ position.second ];
+    const int leading = position.first - position.first % 2;
+    const int trailing = qMin( leading + 1, data.size() - 1 );
+
+    int first, last, unused;
+    mapToModelRows( leading, &first, &unused );
+    mapToModelRows( trailing, &unused, &last );
+
+    int leadingRow = first;
+    int trailingRow = last;
+    if( m_mode == MinMax ) {
+        const Summary summary = summarize( position.second, first, last );
+        // Keep the order of the extremes, so that the line goes through
+        // them the same way the data does
+        if( summary.count > 0 ) {
+            leadingRow = qMin( summary.minRow, summary.maxRow );
+            trailingRow = qMax( summary.minRow, summary.maxRow );
+        }
+    }
+
+    data[ leading ] = modelDataPoint( leadingRow, position.second );
+    if( trailing != leading )
+        data[ trailing ] = modelDataPoint( trailingRow, position.second );
+}
+
+void CartesianDiagramDataCompressor::retrieveLargestTriangleThreeBuckets( int column ) const
+{
+    DataPointVector& data = m_data[ column ];
+    const int bucketCount = data.size();
+    int first, last;
+    m_modelCache.fillColumn( column );
+
+    // The first and the last data point are always kept
+    mapToModelRows( 0, &first, &last );
+    data[ 0 ] = modelDataPoint( first, column );
+    DataPoint previous = data[ 0 ];
+
+    for( int bucket = 1; bucket < bucketCount - 1; ++bucket ) {
+        // The third corner of the triangle is the average of the next bucket
+        int nextFirst, nextLast;
+        mapToModelRows( bucket + 1, &nextFirst, &nextLast );
+        double nextKey = 0.0;
+        double nextValue = 0.0;
+        int values = 0;
+        for( int row = nextFirst; row <= nextLast; ++row ) {
+            const double value = m_modelCache.data( m_model->index( row, column, m_rootIndex ) );
+            if( ISNAN( value ) )
+                continue;
+            nextKey += row;
+            nextValue += value;
+            ++values;
+        }
+        if( values > 0 ) {
+            nextKey /= values;
+            nextValue /= values;
+        } else {
+            nextKey = ( nextFirst + nextLast ) / 2.0;
+            nextValue = ISNAN( previous.value ) ? 0.0 : previous.value;
+        }
+        const double previousValue = ISNAN( previous.value ) ? nextValue : previous.value;
+
+        mapToModelRows( bucket, &first, &last );
+        int selectedRow = first;
+        double maxArea = -1.0;
+        for( int row = first; row <= last; ++row ) {
+            const double value = m_modelCache.data( m_model->index( row, column, m_rootIndex ) );
+            if( ISNAN( value ) )
+                continue;
+            // twice the area of the triangle, which is just as good
+            const double area = qAbs( ( previous.key - nextKey ) * ( value - previousValue )
+                                    - ( previous.key - row ) * ( nextValue - previousValue ) );
+            if( area > maxArea ) {
+                maxArea = area;
+                selectedRow = row;
+            }
+        }
+
+        data[ bucket ] = modelDataPoint( selectedRow, column );
+        if( !ISNAN( data[ bucket ].value ) )
+            previous = data[ bucket ];
+    }
+
+    if( bucketCount > 1 ) {
+        mapToModelRows( bucketCount - 1, &first, &last );
+        data[ bucketCount - 1 ] = modelDataPoint( last, column );
+    }
+}
+
 CartesianDiagramDataCompressor::CachePosition CartesianDiagramDataCompressor::mapToCache(
         const QModelIndex& index ) const
 {
@@ -748,6 +1501,24 @@ QModelIndexList CartesianDiagramDataCompressor::mapToModel( const CachePosition&
     }
 }
 
+void CartesianDiagramDataCompressor::mapToModelRows( int cacheRow, int* first, int* last ) const
+{
+    const qreal ipp = indexesPerPixel();
+    const int rowCount = m_model->rowCount( m_rootIndex );
+    *first = qMin( qRound( cacheRow * ipp ), rowCount - 1 );
+    *last = qBound( *first, qRound( ( cacheRow + 1 ) * ipp ) - 1, rowCount - 1 );
+}
+
+int CartesianDiagramDataCompressor::samplesPerPixel() const
+{
+    return ( m_mode == MinMax || m_mode == FirstLast ) ? 2 : 1;
+}
+
+int CartesianDiagramDataCompressor::cacheRowCount() const
+{
+    return qMin( m_model ? m_model->rowCount( m_rootIndex ) : 0, m_xResolution * samplesPerPixel() );
+}
+
 qreal CartesianDiagramDataCompressor::indexesPerPixel() const
 {
     if ( m_data.size() == 0 ) return 0;
@@ -769,6 +1540,17 @@ void CartesianDiagramDataCompressor::invalidate( const CachePosition& position )
 {
     if ( isValidCachePosition( position ) ) {
         m_data[position.second][position.first] = DataPoint();
+        if ( position.second < m_boundaries.size() ) {
+            BoundariesTree& tree = m_boundaries[position.second];
+            if ( tree.complete && position.first < tree.size && !tree.isDirty[position.first] ) {
+                tree.isDirty[position.first] = true;
+                tree.dirtyRows.append( position.first );
+            }
+        }
+        if ( position.first < m_stackedRows.size() )
+            m_stackedRows[position.first].valid = false;
+        if ( position.second < m_keyOrders.size() )
+            m_keyOrders[position.second].known = false;
         // Also invalidate the data value attributes at "position".
         // Otherwise the user overwrites the attributes without us noticing
         // it because we keep reading what's in the cache.
@@ -818,6 +1600,20 @@ void CartesianDiagramDataCompressor::calculateSampleStepWidth()
     }
 }
 
+void CartesianDiagramDataCompressor::setApproximationMode( ApproximationMode mode )
+{
+    if ( mode != m_mode ) {
+        m_mode = mode;
+        rebuildCache();
+        calculateSampleStepWidth();
+    }
+}
+
+CartesianDiagramDataCompressor::ApproximationMode CartesianDiagramDataCompressor::approximationMode() const
+{
+    return m_mode;
+}
+
 void CartesianDiagramDataCompressor::setDatasetDimension( int dimension )
 {
     if ( dimension != m_datasetDimension ) {
@@ -36,6 +36,7 @@
 
 #include <limits>
 
+#include <QBitArray>
 #include <QPair>
 #include <QVector>
 #include <QObject>
@@ -123,7 +124,29 @@ namespace KDChart {
             // datapoints for a pixel
             Precise,
             // approximate by averaging out over prime number distances
-            SamplingSeven
+            SamplingSeven,
+            // keep the smallest and the biggest value of each pixel, in
+            // the order they appear in, so that spikes remain visible
+            MinMax,
+            // keep the first and the last value of each pixel
+            FirstLast,
+            // keep the value of each pixel that spans the biggest triangle
+            // with the values kept for its neighbors (Largest-Triangle-
+            // Three-Buckets), which preserves the shape of the line
+            LargestTriangleThreeBuckets
+        };
+
+        // what stackedValue() sums up over the datasets
+        enum StackedValueType {
+            // values greater than zero
+            PositiveValues,
+            // values less than zero
+            NegativeValues,
+            // the absolute values
+            AbsoluteValues,
+            // the number of missing values
+            MissingValues,
+            StackedValueTypeCount
         };
 
         explicit CartesianDiagramDataCompressor( QObject* parent = 0 );
@@ -133,6 +156,7 @@ namespace KDChart {
         void setRootIndex( const QModelIndex& root );
         void setResolution( int x, int y );
         void setApproximationMode( ApproximationMode mode );
+        ApproximationMode approximationMode() const;
         void setDatasetDimension( int dimension );
 
         // output: resulting model resolution, data points
@@ -140,9 +164,25 @@ namespace KDChart {
         int modelDataColumns() const;
         int modelDataRows() const;
         const DataPoint& data( const CachePosition& ) const;
+        // the uncompressed data point of a cell of the model
+        DataPoint modelDataPoint( int row, int column ) const;
 
         QPair< QPointF, QPointF > dataBoundaries() const;
 
+        // sum of the values of the datasets [0, column] of a cache row, as
+        // drawn by stacked and percent diagrams
+        qreal stackedValue( int row, int column, StackedValueType type ) const;
+        // sum of the values of all datasets of a cache row
+        qreal stackedTotal( int row, StackedValueType type ) const;
+
+        // whether the keys of a dataset never decrease from one cache row
+        // to the next, which is always the case without x values
+        bool isSortedByKey( int column ) const;
+        // first and last cache row of a dataset sorted by key that have to
+        // be painted to show the keys [minKey, maxKey]: the rows inside the
+        // range and the nearest row with a value on either side of it
+        void rowsInKeyRange( int column, qreal minKey, qreal maxKey, int* first, int* last ) const;
+
         QModelIndexList indexesAt( const CachePosition& position ) const;
         DataValueAttributesList aggregatedAttrs(
                 AbstractDiagram * diagram,
@@ -162,10 +202,14 @@ namespace KDChart {
 
         void slotModelHeaderDataChanged( Qt::Orientation, int, int );
         void slotModelDataChanged( const QModelIndex&, const QModelIndex& );
+        void slotModelAttributesChanged( const QModelIndex&, const QModelIndex& );
         void slotModelLayoutChanged();
+        void slotModelReset();
         // FIXME resolution changes and root index changes should all
         // be catchable with this method:
         void slotDiagramLayoutChanged( AbstractDiagram* );
+        // the hidden state of some data points has changed
+        void slotDiagramDataHidden();
 
         // geometry has changed
         void rebuildCache() const;
@@ -173,8 +217,105 @@ namespace KDChart {
         void clearCache();
 
     private:
+        // smallest and biggest key and value of some data points
+        class Boundaries {
+        public:
+            Boundaries();
+            explicit Boundaries( const DataPoint& point );
+            bool isEmpty() const;
+            void unite( const Boundaries& other );
+
+            qreal xMin;
+            qreal xMax;
+            qreal yMin;
+            qreal yMax;
+        };
+
+        // segment tree of the boundaries of one column of the cache, so
+        // that changing a data point only requires updating its ancestors
+        class BoundariesTree {
+        public:
+            BoundariesTree();
+
+            // number of leaves, i.e. of cache rows
+            int size;
+            // false if all leaves have to be computed
+            bool complete;
+            // node i unites nodes 2i and 2i+1, the leaves are at [size, 2*size)
+            QVector< Boundaries > nodes;
+            // cache rows whose leaves are outdated
+            QVector< int > dirtyRows;
+            QVector< bool > isDirty;
+        };
+
+        // running sums of the values of one cache row over the datasets,
+        // StackedValueTypeCount per dataset
+        class StackedRow {
+        public:
+            StackedRow();
+
+            bool valid;
+            QVector< qreal > sums;
+        };
+
+        // summary of the values of some rows of a column
+        class Summary {
+        public:
+            Summary();
+            void unite( const Summary& other );
+
+            qreal min;
+            qreal max;
+            qreal sum;
+            int minRow;
+            int maxRow;
+            // number of rows with a value
+            int count;
+            // number of rows that are not hidden
+            int visibleCount;
+        };
+
+        // power-of-two pyramid of the summaries of one column: level 0
+        // summarizes blocks of rows, each further level pairs of blocks of
+        // the level below. It doesn't depend on the resolution, so resizing
+        // and zooming don't have to read all rows again.
+        class Pyramid {
+        public:
+            QVector< QVector< Summary > > levels;
+        };
+
+        // hidden state of the rows of one model column, read on demand
+        class HiddenState {
+        public:
+            HiddenState();
+
+            bool known;
+            // if set, the bits aren't needed
+            bool nothingHidden;
+            int hiddenCount;
+            // DataHiddenRole of the whole column when the bits were read
+            bool columnHidden;
+            QBitArray hidden;
+        };
+
+        // order of the keys of one dataset, checked on demand
+        class KeyOrder {
+        public:
+            KeyOrder();
+
+            bool known;
+            bool sorted;
+        };
+
         // mark a cache position as invalid
         void invalidate( const CachePosition& );
+        // mark the boundaries of all cache positions as invalid
+        void invalidateBoundaries();
+        // the running sums of a cache row, computed on demand
+        const StackedRow& stackedRow( int row ) const;
+        void invalidateStackedRows();
+        // update the boundaries tree of a column and return its root
+        Boundaries columnBoundaries( int column ) const;
         // verify it is within the range
         bool isValidCachePosition( const CachePosition& ) const;
 
@@ -182,9 +323,41 @@ namespace KDChart {
         CachePosition mapToCache( int row, int column ) const;
         QModelIndexList mapToModel( const CachePosition& ) const;
         qreal indexesPerPixel() const;
+        // number of cache positions per pixel the approximation mode needs
+        int samplesPerPixel() const;
+        // number of cache positions per column
+        int cacheRowCount() const;
+        // first and last model row represented by the cache row
+        void mapToModelRows( int cacheRow, int* first, int* last ) const;
 
         // retrieve data from the model, put it into the cache
         void retrieveModelData( const CachePosition& ) const;
+        DataPoint sampledDataPoint( const CachePosition& ) const;
+        // MinMax and FirstLast select both points of a pixel at once
+        void retrieveSelectedDataPoints( const CachePosition& ) const;
+        // LTTB selects each point depending on the previous one, so it
+        // always retrieves a whole column
+        void retrieveLargestTriangleThreeBuckets( int column ) const;
+        // Precise approximation of a cache position from the pyramid
+        DataPoint summarizedDataPoint( const CachePosition& ) const;
+
+        Summary rowSummary( int row, int column ) const;
+        // summary of the rows [first, last] of a column, from the pyramid
+        Summary summarize( int column, int first, int last ) const;
+        void buildPyramid( int column ) const;
+        // update the pyramid after the rows [first, last] of a column changed
+        void updatePyramid( int column, int first, int last );
+        void invalidatePyramids();
+
+        // whether the data point at a row and column of the model is hidden
+        bool isHiddenRow( int row, int column ) const;
+        const HiddenState& hiddenState( int column ) const;
+        // re-read the rows [first, last] of a column whose state is known
+        void updateHiddenRows( int column, int first, int last );
+        void invalidateHiddenStates();
+        // drop everything cached for one model column
+        void invalidateColumn( int column );
+        void invalidateKeyOrders();
         // check if a data point is in the cache:
         bool isCached( const CachePosition& ) const;
         // set sample step width according to settings:
@@ -200,6 +373,16 @@ namespace KDChart {
         QModelIndex m_rootIndex;
         ModelDataCache< qreal > m_modelCache;
         mutable DataValueAttributesCache m_dataValueAttributesCache;
+        // one per dataset, built on demand
+        mutable QVector< BoundariesTree > m_boundaries;
+        // one per dataset, built on demand
+        mutable QVector< Pyramid > m_pyramids;
+        // one per cache row, built on demand
+        mutable QVector< StackedRow > m_stackedRows;
+        // one per model column, built on demand
+        mutable QVector< HiddenState > m_hiddenStates;
+        // one per dataset, checked on demand
+        mutable QVector< KeyOrder > m_keyOrders;
         int m_datasetDimension;
     };
 }
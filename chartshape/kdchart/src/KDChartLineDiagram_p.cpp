@@ -22,12 +22,68 @@
 
 #include "KDChartLineDiagram.h"
 #include "KDChartDataValueAttributes.h"
+#include "KDChartCartesianCoordinatePlane.h"
 
 #include "KDChartLineDiagram_p.h"
 
 using namespace KDChart;
 using namespace std;
 
+/*!
+  Clips the line from \a from to \a to to \a rect (Liang-Barsky).
+  Returns false if no part of the line is inside of \a rect.
+*/
+static bool clipLine( const QRectF& rect, QPointF& from, QPointF& to )
+{
+    const qreal dx = to.x() - from.x();
+    const qreal dy = to.y() - from.y();
+    const qreal p[ 4 ] = { -dx, dx, -dy, dy };
+    const qreal q[ 4 ] = { from.x() - rect.left(), rect.right() - from.x(),
+                           from.y() - rect.top(), rect.bottom() - from.y() };
+    qreal t0 = 0.0;
+    qreal t1 = 1.0;
+    for ( int i = 0; i < 4; ++i ) {
+        if ( p[ i ] == 0.0 ) {
+            // parallel to this edge
+            if ( q[ i ] < 0.0 )
+                return false;
+            continue;
+        }
+        const qreal t = q[ i ] / p[ i ];
+        if ( p[ i ] < 0.0 ) {
+            if ( t > t1 )
+                return false;
+            t0 = qMax( t0, t );
+        } else {
+            if ( t < t0 )
+                return false;
+            t1 = qMin( t1, t );
+        }
+    }
+    const QPointF start( from );
+    if ( t0 > 0.0 )
+        from = start + t0 * QPointF( dx, dy );
+    if ( t1 < 1.0 )
+        to = start + t1 * QPointF( dx, dy );
+    return true;
+}
+
+static bool isSamePixel( const QPointF& a, const QPointF& b )
+{
+    return qRound( a.x() ) == qRound( b.x() ) && qRound( a.y() ) == qRound( b.y() );
+}
+
+/*!
+  Makes sure the polyline \a points ends at \a end, the end of its last
+  segment, which has been dropped if it is on the same pixel as its
+  predecessor.
+*/
+static void finishPolyline( QPolygonF& points, const QPointF& end )
+{
+    if ( points.count() && points.last() != end )
+        points << end;
+}
+
 LineDiagram::Private::Private( const Private& rhs )
     : AbstractCartesianDiagram::Private( rhs )
 {
@@ -115,15 +171,32 @@ void LineDiagram::LineDiagramType::paintElements(
         ctx->painter()->setRenderHint ( QPainter::Antialiasing );
     LineAttributesInfoListIterator itline ( lineList );
 
+    // Segments outside of the visible data range are skipped and the rest
+    // is clipped to it, with a margin keeping line joins at the border intact.
+    // The remaining segments are collected into as few polylines as possible.
+    QRectF clipRect;
+    const CartesianCoordinatePlane* plane = dynamic_cast<CartesianCoordinatePlane*>( ctx->coordinatePlane() );
+    if ( plane ) {
+        const QRectF range( plane->visibleDataRange() );
+        clipRect = QRectF( plane->translate( range.topLeft() ),
+                           plane->translate( range.bottomRight() ) ).normalized();
+    }
+
     QBrush curBrush;
     QPen curPen;
     QPolygonF points;
+    // end of the last segment added to points, which may have been dropped
+    // from points for being on the same pixel as its predecessor
+    QPointF curEnd;
+    AttributesSpanCursor<ThreeDLineAttributes> threeDLineAttrs;
+    AttributesSpanCursor<LineAttributes> lineAttrs;
+    AttributesSpanCursor<ValueTrackerAttributes> valueTrackerAttrs;
     while ( itline.hasNext() ) {
         const LineAttributesInfo& lineInfo = itline.next();
         const QModelIndex& index = lineInfo.index;
-        const ThreeDLineAttributes td = diagram()->threeDLineAttributes( index );
-        const LineAttributes la = diagram()->lineAttributes( index );
-        const ValueTrackerAttributes vt = diagram()->valueTrackerAttributes( index );
+        const ThreeDLineAttributes td = cellAttributes( threeDLineAttrs, index, ThreeDLineAttributesRole );
+        const LineAttributes la = cellAttributes( lineAttrs, index, LineAttributesRole );
+        const ValueTrackerAttributes vt = cellAttributes( valueTrackerAttrs, index, ValueTrackerAttributesRole );
 
         if ( !la.isVisible() ) {
             // Do not draw lines, but do draw text and markers
@@ -132,25 +205,39 @@ void LineDiagram::LineDiagramType::paintElements(
         } else {
             const QBrush br( diagram()->brush( index ) );
             const QPen pn( diagram()->pen( index ) );
-            if( points.count() && points.last() == lineInfo.value && curBrush == br && curPen == pn ) {
-                // line goes from last value in points to lineInfo.nextValue
-                reverseMapper().addLine( lineInfo.index.row(), lineInfo.index.column(), points.last(), lineInfo.nextValue );
-                points << lineInfo.nextValue;
+            QPointF from( lineInfo.value );
+            QPointF to( lineInfo.nextValue );
+            const qreal margin = pn.widthF() + 1.0;
+            if ( plane && !clipLine( clipRect.adjusted( -margin, -margin, margin, margin ), from, to ) ) {
+                // invisible, so the polyline is interrupted here
+                finishPolyline( points, curEnd );
+                if( points.count() )
+                    paintPolyline( ctx, curBrush, curPen, points );
+                points.clear();
+            } else if( points.count() && curEnd == from && curBrush == br && curPen == pn ) {
+                // line continues the current polyline
+                reverseMapper().addLine( lineInfo.index.row(), lineInfo.index.column(), from, to );
+                // points on the same pixel add nothing but painting time
+                if ( !isSamePixel( points.last(), to ) )
+                    points << to;
             } else {
+                finishPolyline( points, curEnd );
                 if( points.count() )
                     paintPolyline( ctx, curBrush, curPen, points );
                 curBrush = br;
                 curPen   = pn;
                 points.clear();
-                // line goes from lineInfo.value to lineInfo,nextValue
-                reverseMapper().addLine( lineInfo.index.row(), lineInfo.index.column(), lineInfo.value, lineInfo.nextValue );
-                points << lineInfo.value << lineInfo.nextValue;
+                // line goes from from to to
+                reverseMapper().addLine( lineInfo.index.row(), lineInfo.index.column(), from, to );
+                points << from << to;
             }
+            curEnd = to;
         }
 
         if( vt.isEnabled() )
             paintValueTracker( ctx, vt, lineInfo.value );
     }
+    finishPolyline( points, curEnd );
     if( points.count() )
         paintPolyline( ctx, curBrush, curPen, points );
     // paint all data value texts and the point markers
@@ -342,3 +429,26 @@ double LineDiagram::LineDiagramType::interpolateMissingValue( const CartesianDia
     else
         return std::numeric_limits< double >::quiet_NaN();
 }
+
+double LineDiagram::LineDiagramType::stackedValue( int row, int column, bool bridged, bool positiveOnly ) const
+{
+    double sum = compressor().stackedValue( row, column, CartesianDiagramDataCompressor::PositiveValues );
+    if( !positiveOnly )
+        sum += compressor().stackedValue( row, column, CartesianDiagramDataCompressor::NegativeValues );
+
+    // the cached sums skip missing values, so only bridged ones need a look
+    if( bridged && compressor().stackedValue( row, column, CartesianDiagramDataCompressor::MissingValues ) > 0.0 )
+    {
+        for( int column2 = column; column2 >= 0; --column2 )
+        {
+            const CartesianDiagramDataCompressor::CachePosition position( row, column2 );
+            if( !ISNAN( compressor().data( position ).value ) )
+                continue;
+            const double interpolation = interpolateMissingValue( position );
+            if( ISNAN( interpolation ) || ( positiveOnly && interpolation <= 0.0 ) )
+                continue;
+            sum += interpolation;
+        }
+    }
+    return sum;
+}
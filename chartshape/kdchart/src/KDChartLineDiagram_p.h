@@ -104,6 +104,9 @@ namespace KDChart {
         CartesianDiagramDataCompressor& compressor() const;
 
         double interpolateMissingValue( const CartesianDiagramDataCompressor::CachePosition& pos ) const;
+        // sum of the values of the datasets [0, column] of a row, including
+        // interpolated missing values if they are bridged
+        double stackedValue( int row, int column, bool bridged, bool positiveOnly ) const;
 
         int datasetDimension() const;
         LineAttributes::MissingValuesPolicy getCellValues(
@@ -142,6 +145,21 @@ namespace KDChart {
         void paintValueTracker( PaintContext* ctx, const ValueTrackerAttributes& vt,
                                 const QPointF& at );
 
+        // Returns the attributes of the source model index \a index, resolved
+        // once per span of equal attributes of its column
+        template< typename T >
+        T cellAttributes( AttributesSpanCursor<T>& cursor, const QModelIndex& index, int role ) const
+        {
+            if ( index.isValid() && index.column() != cursor.column() )
+                cursor.reset( index.column(),
+                              attributesModel()->columnSpans( index.column(), role,
+                                                              attributesModelRootIndex() ) );
+            if ( cursor.contains( index ) )
+                return cursor.value( index.row() );
+            return qVariantValue< T >( attributesModel()->data(
+                       attributesModel()->mapFromSource( index ), role ) );
+        }
+
         LineDiagram::Private* m_private;
     };
 
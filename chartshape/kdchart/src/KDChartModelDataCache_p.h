@@ -27,8 +27,11 @@
 
 #include <QObject>
 #include <QModelIndex>
+#include <QtAlgorithms>
+#include <QVariant>
 #include <QVector>
 
+#include "KDChartGlobal.h"
 #include "kdchart_export.h"
 
 class QAbstractItemModel;
@@ -89,6 +92,188 @@ namespace KDChart
         {
             return std::numeric_limits< double >::quiet_NaN();
         }
+
+        // Column-major storage of a table of values with a validity bit per
+        // cell. All columns share a gap of unused rows, which is moved to
+        // where rows are inserted or removed. Appending rows, or inserting
+        // them repeatedly at the same position, thus only moves few cells.
+        template< class T >
+        class CellStorage
+        {
+        public:
+            CellStorage()
+                : m_rowCount( 0 ),
+                  m_columnCount( 0 ),
+                  m_capacity( 0 ),
+                  m_gapStart( 0 )
+            {
+            }
+
+            int rowCount() const
+            {
+                return m_rowCount;
+            }
+
+            int columnCount() const
+            {
+                return m_columnCount;
+            }
+
+            // resizes the table and invalidates all of its cells
+            void reset( int rows, int columns )
+            {
+                m_rowCount = rows;
+                m_columnCount = columns;
+                m_capacity = rows;
+                m_gapStart = rows;
+                m_values = QVector< T >( m_capacity * m_columnCount );
+                m_valid = QVector< quint32 >( wordsPerColumn() * m_columnCount, 0 );
+            }
+
+            bool isValid( int row, int column ) const
+            {
+                return bit( column, physicalRow( row ) );
+            }
+
+            const T& value( int row, int column ) const
+            {
+                return m_values.at( column * m_capacity + physicalRow( row ) );
+            }
+
+            void setValue( int row, int column, const T& value )
+            {
+                const int physical = physicalRow( row );
+                m_values[ column * m_capacity + physical ] = value;
+                setBit( column, physical, true );
+            }
+
+            void invalidate( int row, int column )
+            {
+                setBit( column, physicalRow( row ), false );
+            }
+
+            void insertRows( int start, int count )
+            {
+                if( m_capacity - m_rowCount < count )
+                    reallocate( qMax( 2 * m_capacity, m_rowCount + count ), start );
+                else
+                    moveGap( start );
+
+                // the new rows are taken from the front of the gap
+                for( int column = 0; column < m_columnCount; ++column )
+                    for( int row = start; row < start + count; ++row )
+                        setBit( column, row, false );
+                m_gapStart += count;
+                m_rowCount += count;
+            }
+
+            void removeRows( int start, int count )
+            {
+                // the removed rows become the front of the gap
+                moveGap( start + count );
+                m_gapStart = start;
+                m_rowCount -= count;
+            }
+
+            void insertColumns( int start, int count )
+            {
+                m_values.insert( start * m_capacity, count * m_capacity, T() );
+                m_valid.insert( start * wordsPerColumn(), count * wordsPerColumn(), 0 );
+                m_columnCount += count;
+            }
+
+            void removeColumns( int start, int count )
+            {
+                m_values.remove( start * m_capacity, count * m_capacity );
+                m_valid.remove( start * wordsPerColumn(), count * wordsPerColumn() );
+                m_columnCount -= count;
+            }
+
+        private:
+            int gapSize() const
+            {
+                return m_capacity - m_rowCount;
+            }
+
+            int physicalRow( int row ) const
+            {
+                return row < m_gapStart ? row : row + gapSize();
+            }
+
+            // each column starts at a word boundary of the validity bits
+            int wordsPerColumn() const
+            {
+                return ( m_capacity + 31 ) / 32;
+            }
+
+            bool bit( int column, int physicalRow ) const
+            {
+                return m_valid.at( column * wordsPerColumn() + physicalRow / 32 ) & ( 1u << ( physicalRow % 32 ) );
+            }
+
+            void setBit( int column, int physicalRow, bool value )
+            {
+                quint32& word = m_valid[ column * wordsPerColumn() + physicalRow / 32 ];
+                if( value )
+                    word |= 1u << ( physicalRow % 32 );
+                else
+                    word &= ~( 1u << ( physicalRow % 32 ) );
+            }
+
+            void moveGap( int row )
+            {
+                const int gap = gapSize();
+                if( row == m_gapStart || gap == 0 ) {
+                    m_gapStart = row;
+                    return;
+                }
+
+                for( int column = 0; column < m_columnCount; ++column ) {
+                    T* values = m_values.data() + column * m_capacity;
+                    if( row < m_gapStart ) {
+                        // the rows [row, m_gapStart) move behind the gap
+                        qCopyBackward( values + row, values + m_gapStart, values + m_gapStart + gap );
+                        for( int physical = m_gapStart - 1; physical >= row; --physical )
+                            setBit( column, physical + gap, bit( column, physical ) );
+                    } else {
+                        // the rows [m_gapStart, row) move in front of the gap
+                        qCopy( values + m_gapStart + gap, values + row + gap, values + m_gapStart );
+                        for( int physical = m_gapStart; physical < row; ++physical )
+                            setBit( column, physical, bit( column, physical + gap ) );
+                    }
+                }
+                m_gapStart = row;
+            }
+
+            void reallocate( int capacity, int gapStart )
+            {
+                CellStorage< T > storage;
+                storage.m_rowCount = m_rowCount;
+                storage.m_columnCount = m_columnCount;
+                storage.m_capacity = capacity;
+                storage.m_gapStart = gapStart;
+                storage.m_values = QVector< T >( capacity * m_columnCount );
+                storage.m_valid = QVector< quint32 >( storage.wordsPerColumn() * m_columnCount, 0 );
+
+                for( int column = 0; column < m_columnCount; ++column ) {
+                    for( int row = 0; row < m_rowCount; ++row ) {
+                        const int from = physicalRow( row );
+                        const int to = storage.physicalRow( row );
+                        storage.m_values[ column * capacity + to ] = m_values.at( column * m_capacity + from );
+                        storage.setBit( column, to, bit( column, from ) );
+                    }
+                }
+                *this = storage;
+            }
+
+            int m_rowCount;
+            int m_columnCount;
+            // rows per column including the gap
+            int m_capacity;
+            int m_gapStart;
+            QVector< T > m_values;
+            QVector< quint32 > m_valid;
+        };
     }
 
     template< class T, int ROLE = Qt::DisplayRole >
@@ -110,28 +295,28 @@ namespace KDChart
             if( !index.isValid() || index.parent() != m_rootIndex || index.row() >= m_model->rowCount(m_rootIndex) || index.column() >= m_model->columnCount(m_rootIndex) )
                 return ModelDataCachePrivate::nan< T >();
 
-            if( index.row() >= m_data.count() )
+            if( index.row() >= m_storage.rowCount() )
             {
                 qWarning( "KDChart didn't got signal rowsInserted, resetModel or layoutChanged, "
                           "but an index with a row outside of the known bounds." );
                           
                 // apparently, data were added behind our back (w/o signals)
                 const_cast< ModelDataCache< T, ROLE >* >( this )->rowsInserted( m_rootIndex, 
-                                                                                m_data.count(), 
+                                                                                m_storage.rowCount(), 
                                                                                 m_model->rowCount( m_rootIndex ) - 1 );
-                Q_ASSERT( index.row() < m_data.count() );
+                Q_ASSERT( index.row() < m_storage.rowCount() );
             }
 
-            if( index.column() >= m_data.first().count() )
+            if( index.column() >= m_storage.columnCount() )
             {
                 qWarning( "KDChart didn't got signal columnsInserted, resetModel or layoutChanged, "
                           "but an index with a column outside of the known bounds." );
                           
                 // apparently, data were added behind our back (w/o signals)
                 const_cast< ModelDataCache< T, ROLE >* >( this )->columnsInserted( m_rootIndex, 
-                                                                                   m_data.first().count(), 
+                                                                                   m_storage.columnCount(), 
                                                                                    m_model->columnCount( m_rootIndex ) - 1 );
-                Q_ASSERT( index.column() < m_data.first().count() );
+                Q_ASSERT( index.column() < m_storage.columnCount() );
             }
 
             return data( index.row(), index.column() );
@@ -145,15 +330,45 @@ namespace KDChart
             Q_ASSERT( row < m_model->rowCount(m_rootIndex) );
             Q_ASSERT( column < m_model->columnCount(m_rootIndex) );
 
-            Q_ASSERT( row < m_data.count() );
-            Q_ASSERT( column < m_data.first().count() );
+            Q_ASSERT( row < m_storage.rowCount() );
+            Q_ASSERT( column < m_storage.columnCount() );
 
             if( isCached( row, column ) )
-                return m_data.at( row ).at( column );
+                return m_storage.value( row, column );
 
             return fetchFromModel( row, column, ROLE );
         }
 
+        // Loads all rows of a column that aren't cached yet. If the model
+        // hands out whole columns through ColumnDataRole, that takes a
+        // single call.
+        void fillColumn( int column ) const
+        {
+            if( m_model == 0 || column < 0 || column >= m_storage.columnCount() )
+                return;
+
+            const int rowCount = m_storage.rowCount();
+            if( ROLE == Qt::DisplayRole && !m_rootIndex.isValid() )
+            {
+                const QVariantList values = m_model->headerData( column, Qt::Horizontal, ColumnDataRole ).toList();
+                if( values.count() == rowCount )
+                {
+                    for( int row = 0; row < rowCount; ++row )
+                    {
+                        if( !isCached( row, column ) )
+                            m_storage.setValue( row, column, toValue( values.at( row ) ) );
+                    }
+                    return;
+                }
+            }
+
+            for( int row = 0; row < rowCount; ++row )
+            {
+                if( !isCached( row, column ) )
+                    fetchFromModel( row, column, ROLE );
+            }
+        }
+
         void setModel( QAbstractItemModel* model )
         {
             if( m_model != 0 )
@@ -187,7 +402,13 @@ namespace KDChart
     protected:
         bool isCached( int row, int column ) const
         {
-            return m_cacheValid.at( row ).at( column );
+            return m_storage.isValid( row, column );
+        }
+
+        static T toValue( const QVariant& data )
+        {
+            return data.isNull() ? ModelDataCachePrivate::nan< T >()
+                                 : qVariantValue< T >( data );
         }
 
         T fetchFromModel( int row, int column, int role ) const
@@ -195,12 +416,9 @@ namespace KDChart
             Q_ASSERT( m_model != 0 );
 
             const QModelIndex index = m_model->index( row, column, m_rootIndex );
-            const QVariant data = index.data( role );
-            const T value = data.isNull() ? ModelDataCachePrivate::nan< T >() 
-                                          : qVariantValue< T >( data );
-    
-            m_data[ row ][ column ] = value;
-            m_cacheValid[ row ][ column ] = true;
+            const T value = toValue( index.data( role ) );
+
+            m_storage.setValue( row, column, value );
 
             return value;
         }
@@ -216,14 +434,8 @@ namespace KDChart
             Q_ASSERT( start <= end );
             Q_ASSERT( end - start + 1 <= m_model->columnCount(m_rootIndex) );
             
-            const int rowCount = m_data.count();
-            for( int row = 0; row < rowCount; ++row )
-            {
-                m_data[ row ].insert( start, end - start + 1, T() );
-                m_cacheValid[ row ].insert( start, end - start + 1, false );
-                Q_ASSERT( m_data.at( row ).count() == m_model->columnCount( m_rootIndex ) );
-                Q_ASSERT( m_cacheValid.at( row ).count() == m_model->columnCount( m_rootIndex ) );
-            }
+            m_storage.insertColumns( start, end - start + 1 );
+            Q_ASSERT( m_storage.columnCount() == m_model->columnCount( m_rootIndex ) );
         }
 
         void columnsRemoved( const QModelIndex& parent, int start, int end )
@@ -236,14 +448,8 @@ namespace KDChart
             Q_ASSERT( start <= end );
             Q_ASSERT( end - start + 1 <= m_model->columnCount(m_rootIndex) );
 
-            const int rowCount = m_data.count();
-            for( int row = 0; row < rowCount; ++row )
-            {
-                m_data[ row ].remove( start, end - start + 1 );
-                m_cacheValid[ row ].remove( start, end - start + 1 );
-                Q_ASSERT( m_data.at( row ).count() == m_model->columnCount( m_rootIndex ) );
-                Q_ASSERT( m_cacheValid.at( row ).count() == m_model->columnCount( m_rootIndex ) );
-            }
+            m_storage.removeColumns( start, end - start + 1 );
+            Q_ASSERT( m_storage.columnCount() == m_model->columnCount( m_rootIndex ) );
         }
 
         void dataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight )
@@ -265,11 +471,11 @@ namespace KDChart
             Q_ASSERT( maxRow < m_model->rowCount( m_rootIndex ) );
             Q_ASSERT( maxCol < m_model->columnCount( m_rootIndex ) );
 
-            for( int row = minRow; row <= maxRow; ++row )
+            for( int col = minCol; col <= maxCol; ++col )
             {
-                for( int col = minCol; col <= maxCol; ++col )
+                for( int row = minRow; row <= maxRow; ++row )
                 {
-                    m_cacheValid[ row ][ col ] = false;
+                    m_storage.invalidate( row, col );
                     Q_ASSERT( !isCached( row, col ) );
                 }
             }
@@ -282,17 +488,13 @@ namespace KDChart
 
         void modelReset() 
         {
-            m_data.clear();
-            m_cacheValid.clear();
-
             if( m_model == 0 )
+            {
+                m_storage.reset( 0, 0 );
                 return;
-   
-            m_data.fill( QVector< T >( m_model->columnCount( m_rootIndex ) ), m_model->rowCount( m_rootIndex ) );
-            m_cacheValid.fill( QVector< bool >( m_model->columnCount( m_rootIndex ), false ), m_model->rowCount( m_rootIndex ) );
+            }
 
-            Q_ASSERT( m_data.count() == m_model->rowCount( m_rootIndex ) );
-            Q_ASSERT( m_cacheValid.count() == m_model->rowCount( m_rootIndex ) );
+            m_storage.reset( m_model->rowCount( m_rootIndex ), m_model->columnCount( m_rootIndex ) );
         }
 
         void rowsInserted( const QModelIndex& parent, int start, int end )
@@ -305,11 +507,9 @@ namespace KDChart
             Q_ASSERT( start <= end );
             Q_ASSERT( end - start + 1 <= m_model->rowCount(m_rootIndex) );
             
-            m_data.insert( start, end - start + 1, QVector< T >( m_model->columnCount( m_rootIndex ) ) );
-            m_cacheValid.insert( start, end - start + 1, QVector< bool >( m_model->columnCount( m_rootIndex ), false ) );
+            m_storage.insertRows( start, end - start + 1 );
 
-            Q_ASSERT( m_data.count() == m_model->rowCount( m_rootIndex ) );
-            Q_ASSERT( m_cacheValid.count() == m_model->rowCount( m_rootIndex ) );
+            Q_ASSERT( m_storage.rowCount() == m_model->rowCount( m_rootIndex ) );
         }
 
         void rowsRemoved( const QModelIndex& parent, int start, int end )
@@ -322,11 +522,9 @@ namespace KDChart
             Q_ASSERT( start <= end );
             Q_ASSERT( end - start + 1 <= m_model->rowCount(m_rootIndex) );
 
-            m_data.remove( start, end - start + 1 );
-            m_cacheValid.remove( start, end - start + 1 );
+            m_storage.removeRows( start, end - start + 1 );
 
-            Q_ASSERT( m_data.count() == m_model->rowCount( m_rootIndex ) );
-            Q_ASSERT( m_cacheValid.count() == m_model->rowCount( m_rootIndex ) );
+            Q_ASSERT( m_storage.rowCount() == m_model->rowCount( m_rootIndex ) );
         }
 
         void resetModel()
@@ -340,8 +538,7 @@ namespace KDChart
         QAbstractItemModel* m_model;
         QModelIndex m_rootIndex;
         ModelDataCachePrivate::ModelSignalMapperConnector m_connector;
-        mutable QVector< QVector< T > > m_data;
-        mutable QVector< QVector< bool > > m_cacheValid;
+        mutable ModelDataCachePrivate::CellStorage< T > m_storage;
     };
 }
 
@@ -121,6 +121,12 @@ void NormalLineDiagram::paint( PaintContext* ctx )
     maxFound = columnCount;
     // ^^^ temp
 
+    // Only the rows around the visible range of keys have to be painted
+    const QRectF visibleRange = plane->visibleDataRange();
+    const qreal keyOffset = diagram()->centerDataPoints() ? 0.5 : 0.0;
+    const qreal minKey = qMin( visibleRange.left(), visibleRange.right() ) - keyOffset;
+    const qreal maxKey = qMax( visibleRange.left(), visibleRange.right() ) - keyOffset;
+
     // Reverse order of data sets?
     bool rev = diagram()->reverseDatasetOrder();
     for( int column = rev ? columnCount - 1 : 0;
@@ -136,14 +142,19 @@ void NormalLineDiagram::paint( PaintContext* ctx )
         const qreal minYValue = qMin(plane->visibleDataRange().bottom(), plane->visibleDataRange().top());
 
         CartesianDiagramDataCompressor::CachePosition previousCellPosition;
-        for ( int row = 0; row < rowCount; ++row ) {
+        AttributesSpanCursor<LineAttributes> lineAttrs;
+        int firstRow = 0;
+        int lastRow = rowCount - 1;
+        if ( compressor().isSortedByKey( column ) )
+            compressor().rowsInKeyRange( column, minKey, maxKey, &firstRow, &lastRow );
+        for ( int row = firstRow; row <= lastRow; ++row ) {
             const CartesianDiagramDataCompressor::CachePosition position( row, column );
             // get where to draw the line from:
             CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
 
             const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
 
-            const LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
+            const LineAttributes laCell = cellAttributes( lineAttrs, sourceIndex, LineAttributesRole );
             const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
 
             // lower or upper bounding for the highlighted area
@@ -140,6 +140,8 @@ void NormalLyingBarDiagram::paint(  PaintContext* ctx )
 
     calculateValueAndGapWidths( rowCount, colCount,groupWidth,
                                 barWidth, spaceBetweenBars, spaceBetweenGroups );
+    // without gaps, the bars of a group or neighboring groups touch
+    setBarsMayOverlap( ( colCount > 1 && spaceBetweenBars <= 0 ) || spaceBetweenGroups <= 0 );
 
     DataValueTextInfoList list;
 
@@ -184,5 +186,6 @@ void NormalLyingBarDiagram::paint(  PaintContext* ctx )
             paintBars( ctx, sourceIndex, rect, maxDepth );
         }
     }
+    paintBatchedBars( ctx );
     paintDataValueTextsAndMarkers(  diagram(),  ctx,  list,  false );
 }
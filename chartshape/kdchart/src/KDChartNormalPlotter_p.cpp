@@ -57,6 +57,10 @@ void NormalPlotter::paint( PaintContext* ctx )
 
     DataValueTextInfoList textInfoList;
 
+    const QRectF visibleRange = plane->visibleDataRange();
+    const qreal minKey = qMin( visibleRange.left(), visibleRange.right() );
+    const qreal maxKey = qMax( visibleRange.left(), visibleRange.right() );
+
     for( int column = 0; column < colCount; ++column )
     {
         LineAttributesInfoList lineList;
@@ -64,11 +68,32 @@ void NormalPlotter::paint( PaintContext* ctx )
         CartesianDiagramDataCompressor::CachePosition previousCellPosition;
         CartesianDiagramDataCompressor::DataPoint lastPoint;
 
-        for( int row = 0; row < rowCount; ++row )
+        // If the x values are sorted, only the rows around the visible
+        // range have to be looked at
+        const bool sorted = compressor().isSortedByKey( column );
+        int firstRow = 0;
+        int lastRow = rowCount - 1;
+        if( sorted )
+            compressor().rowsInKeyRange( column, minKey, maxKey, &firstRow, &lastRow );
+
+        for( int row = firstRow; row <= lastRow; ++row )
         {
             const CartesianDiagramDataCompressor::CachePosition position( row, column );
             const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
 
+            // Otherwise skip the segments on one side of the visible range
+            // before looking up any attributes
+            if( !sorted && !ISNAN( point.key ) && !ISNAN( point.value )
+                && ( point.key < minKey || point.key > maxKey )
+                && ( ISNAN( lastPoint.key ) || ISNAN( lastPoint.value )
+                     || ( ( point.key < minKey ) == ( lastPoint.key < minKey )
+                          && ( point.key > maxKey ) == ( lastPoint.key > maxKey ) ) ) )
+            {
+                previousCellPosition = position;
+                lastPoint = point;
+                continue;
+            }
+
             const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
             LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
             const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
@@ -109,24 +109,11 @@ void PercentBarDiagram::paint( PaintContext* ctx )
 
     DataValueTextInfoList list;
     const double maxValue = 100; // always 100 %
-    double sumValues = 0;
     QVector <double > sumValuesVector;
 
     //calculate sum of values for each column and store
     for( int row = 0; row < rowCount; ++row )
-    {
-        for( int col = 0; col < colCount; ++col )
-        {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-            //if ( point.value > 0 )
-            sumValues += qMax( point.value, -point.value );
-            if ( col == colCount - 1 ) {
-                sumValuesVector <<  sumValues ;
-                sumValues = 0;
-            }
-        }
-    }
+        sumValuesVector << compressor().stackedTotal( row, CartesianDiagramDataCompressor::AbsoluteValues );
 
     // calculate stacked percent value
     for( int col = 0; col < colCount; ++col )
@@ -162,13 +149,8 @@ void PercentBarDiagram::paint( PaintContext* ctx )
             
             // calculate stacked percent value
             // we only take in account positives values for now.
-            for( int k = col; k >= 0 ; --k )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( row, k );
-                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                stackedValues += qMax( point.value, -point.value );
-                key = point.key;
-            }
+            stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::AbsoluteValues );
+            key = compressor().data( CartesianDiagramDataCompressor::CachePosition( row, 0 ) ).key;
 
             QPointF point, previousPoint;
             if(  sumValuesVector.at( row ) != 0 && value > 0 ) {
@@ -186,5 +168,6 @@ void PercentBarDiagram::paint( PaintContext* ctx )
             paintBars( ctx, sourceIndex, rect, maxDepth );
         }
     }
+    paintBatchedBars( ctx );
     paintDataValueTextsAndMarkers(  diagram(),  ctx,  list,  false );
 }
@@ -79,7 +79,6 @@ void PercentLineDiagram::paint(  PaintContext* ctx )
 //    }
     maxFound = columnCount;
     // ^^^ temp
-    const int lastVisibleColumn = maxFound - 1;
 
     DataValueTextInfoList list;
     LineAttributesInfoList lineList;
@@ -88,29 +87,31 @@ void PercentLineDiagram::paint(  PaintContext* ctx )
     //FIXME(khz): add LineAttributes::MissingValuesPolicy support for LineDiagram::Stacked and ::Percent
 
     double maxValue = 100; // always 100%
-    double sumValues = 0;
     QVector <double > percentSumValues;
 
     //calculate sum of values for each column and store
     for ( int row = 0; row < rowCount; ++row )
     {
-        for( int col = 0; col < columnCount; ++col )
+        double sumValues = compressor().stackedTotal( row, CartesianDiagramDataCompressor::PositiveValues );
+        // missing values count if they are bridged, which is up to each cell
+        if ( compressor().stackedTotal( row, CartesianDiagramDataCompressor::MissingValues ) > 0.0 )
         {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-            const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
-            const LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
-            const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
-            if( ISNAN( point.value ) && policy == LineAttributes::MissingValuesAreBridged )
-                point.value = interpolateMissingValue( position );
-            if ( point.value > 0 )
-                sumValues += point.value;
-            if ( col == lastVisibleColumn )
+            for( int col = 0; col < columnCount; ++col )
             {
-                percentSumValues << sumValues ;
-                sumValues = 0;
+                const CartesianDiagramDataCompressor::CachePosition position( row, col );
+                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
+                if ( !ISNAN( point.value ) )
+                    continue;
+                const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
+                const LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
+                if ( laCell.missingValuesPolicy() != LineAttributes::MissingValuesAreBridged )
+                    continue;
+                const double value = interpolateMissingValue( position );
+                if ( value > 0 )
+                    sumValues += value;
             }
         }
+        percentSumValues << sumValues;
     }
 
     QList<QPointF> bottomPoints;
@@ -123,46 +124,22 @@ void PercentLineDiagram::paint(  PaintContext* ctx )
         QModelIndex indexPreviousCell;
         QList<QPolygonF> areas;
         QList<QPointF> points;
+        AttributesSpanCursor<LineAttributes> lineAttrs;
 
         for( int row = 0; row < rowCount; ++row )
         {
             const CartesianDiagramDataCompressor::CachePosition position( row, column );
             CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
             const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
-            const LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
+            const LineAttributes laCell = cellAttributes( lineAttrs, sourceIndex, LineAttributesRole );
             const bool bDisplayCellArea = laCell.displayArea();
 
-            double stackedValues = 0, nextValues = 0, nextKey = 0;
-            for ( int column2 = column;
-                  column2 >= 0;//datasetDimension() - 1;
-                  column2 -= 1 )//datasetDimension() )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( row, column2 );
-                CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-
-                const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
-                const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
-                if( ISNAN( point.value ) && policy == LineAttributes::MissingValuesAreBridged )
-                    point.value = interpolateMissingValue( position );
-
-                const double val = point.value;
-                if( val > 0 )
-                    stackedValues += val;
-                //qDebug() << valueForCell( iRow, iColumn2 );
-                if ( row + 1 < rowCount ){
-                    const CartesianDiagramDataCompressor::CachePosition position( row + 1, column2 );
-                    CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-
-                    const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
-                    const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
-                    if( ISNAN( point.value ) && policy == LineAttributes::MissingValuesAreBridged )
-                        point.value = interpolateMissingValue( position );
-
-                    const double val = point.value;
-                    if( val > 0 )
-                        nextValues += val;
-                    nextKey = point.key;
-                }
+            const bool bridged = laCell.missingValuesPolicy() == LineAttributes::MissingValuesAreBridged;
+            double stackedValues = stackedValue( row, column, bridged, true );
+            double nextValues = 0, nextKey = 0;
+            if ( row + 1 < rowCount ){
+                nextValues = stackedValue( row + 1, column, bridged, true );
+                nextKey = compressor().data( CartesianDiagramDataCompressor::CachePosition( row + 1, 0 ) ).key;
             }
             if ( percentSumValues.at( row ) != 0  )
                 stackedValues = stackedValues / percentSumValues.at( row ) * maxValue;
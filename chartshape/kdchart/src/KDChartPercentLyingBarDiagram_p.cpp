@@ -130,24 +130,11 @@ void PercentLyingBarDiagram::paint( PaintContext* ctx )
     
     DataValueTextInfoList list;
     const double maxValue = 100.0; // always 100 %
-    double sumValues = 0;
     QVector <double > sumValuesVector;
 
     //calculate sum of values for each column and store
     for( int row = 0; row < rowCount; ++row )
-    {
-        for( int col = 0; col < colCount; ++col )
-        {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-            //if ( point.value > 0 )
-            sumValues += qMax( point.value, -point.value );
-            if ( col == colCount - 1 ) {
-                sumValuesVector <<  sumValues ;
-                sumValues = 0;
-            }
-        }
-    }
+        sumValuesVector << compressor().stackedTotal( row, CartesianDiagramDataCompressor::AbsoluteValues );
 
     // calculate stacked percent value
     for( int curRow = rowCount - 1; curRow >= 0; --curRow )
@@ -186,13 +173,8 @@ void PercentLyingBarDiagram::paint( PaintContext* ctx )
             
             // calculate stacked percent value
             // we only take in account positives values for now.
-            for( int k = col; k >= 0 ; --k )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( curRow, k );
-                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                stackedValues += qMax( point.value, -point.value );
-                key = point.key;
-            }
+            stackedValues = compressor().stackedValue( curRow, col, CartesianDiagramDataCompressor::AbsoluteValues );
+            key = compressor().data( CartesianDiagramDataCompressor::CachePosition( curRow, 0 ) ).key;
 
             QPointF point, previousPoint;
             if(  sumValuesVector.at( curRow ) != 0 && value > 0 ) {
@@ -214,5 +196,6 @@ void PercentLyingBarDiagram::paint( PaintContext* ctx )
             paintBars( ctx, sourceIndex, rect, maxDepth );
         }
     }
+    paintBatchedBars( ctx );
     paintDataValueTextsAndMarkers(  diagram(),  ctx,  list,  false );
 }
@@ -232,6 +232,7 @@ void PieDiagram::paintInternal(PaintContext* ctx, QRectF& textBoundingRect)
 
     d->startAngles.resize( colCount );
     d->angleLens.resize( colCount );
+    d->sliceGeometry.resize( colCount );
 
     // compute position
     d->size = qMin( contentsRect.width(), contentsRect.height() ); // initial size
@@ -459,6 +460,14 @@ void PieDiagram::drawOnePie( QPainter* painter,
 
         const QRectF drawPosition = piePosition( dataset, pie );
 
+        // drop the cached geometry of this pie if anything it depends on
+        // has changed since it was built
+        PieSliceGeometry& geometry = d->sliceGeometry[ pie ];
+        if ( !geometry.matches( d->startAngles[ pie ], angleLen, drawPosition,
+                                granularity, threeDAttrs.isEnabled(), threeDAttrs.depth() ) )
+            geometry = PieSliceGeometry( d->startAngles[ pie ], angleLen, drawPosition,
+                                         granularity, threeDAttrs.isEnabled(), threeDAttrs.depth() );
+
         draw3DEffect( painter,
             drawPosition, dataset, pie,
             granularity,
@@ -499,6 +508,41 @@ void PieDiagram::drawPieSurface( QPainter* painter,
 //            pen.setColor( QColor( 0, 0, 0 ) );
 //        painter->setPen( pen );
 
+        PieSliceGeometry& geometry = d->sliceGeometry[ pie ];
+        if ( !geometry.hasSurface ) {
+            if ( angleLen != 360 ) {
+                // the top of this piece
+                // Start with getting the points for the arc.
+                const int arcPoints = static_cast<int>(trunc( angleLen / granularity ));
+                QPolygonF poly( arcPoints+2 );
+                qreal degree=0.0;
+                int iPoint = 0;
+                bool perfectMatch = false;
+
+                while ( degree <= angleLen ){
+                    poly[ iPoint ] = pointOnCircle( drawPosition, startAngle + degree );
+                    //qDebug() << degree << angleLen << poly[ iPoint ];
+                    perfectMatch = (degree == angleLen);
+                    degree += granularity;
+                    ++iPoint;
+                }
+                // if necessary add one more point to fill the last small gap
+                if( ! perfectMatch ){
+                    poly[ iPoint ] = pointOnCircle( drawPosition, startAngle + angleLen );
+
+                    // add the center point of the piece
+                    poly.append( drawPosition.center() );
+                }else{
+                    poly[ iPoint ] = drawPosition.center();
+                }
+                geometry.surface = poly;
+            }
+            geometry.north = pointOnCircle( drawPosition, startAngle + angleLen/2.0 );
+            geometry.northEast = pointOnCircle( drawPosition, startAngle );
+            geometry.northWest = pointOnCircle( drawPosition, startAngle + angleLen );
+            geometry.hasSurface = true;
+        }
+
         if ( angleLen == 360 ) {
             // full circle, avoid nasty line in the middle
             painter->drawEllipse( drawPosition );
@@ -507,35 +551,11 @@ void PieDiagram::drawPieSurface( QPainter* painter,
             QPolygonF poly( drawPosition );
             d->reverseMapper.addPolygon( index.row(), index.column(), poly );
         } else {
-            // draw the top of this piece
-            // Start with getting the points for the arc.
-            const int arcPoints = static_cast<int>(trunc( angleLen / granularity ));
-            QPolygonF poly( arcPoints+2 );
-            qreal degree=0.0;
-            int iPoint = 0;
-            bool perfectMatch = false;
-
-            while ( degree <= angleLen ){
-                poly[ iPoint ] = pointOnCircle( drawPosition, startAngle + degree );
-                //qDebug() << degree << angleLen << poly[ iPoint ];
-                perfectMatch = (degree == angleLen);
-                degree += granularity;
-                ++iPoint;
-            }
-            // if necessary add one more point to fill the last small gap
-            if( ! perfectMatch ){
-                poly[ iPoint ] = pointOnCircle( drawPosition, startAngle + angleLen );
-
-                // add the center point of the piece
-                poly.append( drawPosition.center() );
-            }else{
-                poly[ iPoint ] = drawPosition.center();
-            }
             //find the value and paint it
             //fix value position
-            d->reverseMapper.addPolygon( index.row(), index.column(), poly );
-			
-            painter->drawPolygon( poly );
+            d->reverseMapper.addPolygon( index.row(), index.column(), geometry.surface );
+
+            painter->drawPolygon( geometry.surface );
         }
         // the new code is setting the needed position points according to the slice:
         // all is calculated as if the slice were 'standing' on it's tip and the border
@@ -545,10 +565,10 @@ void PieDiagram::drawPieSurface( QPainter* painter,
         const QPointF south = drawPosition.center();
         const QPointF southEast = south;
         const QPointF southWest = south;
-        const QPointF north = pointOnCircle( drawPosition, startAngle + angleLen/2.0 );
+        const QPointF north = geometry.north;
 
-        const QPointF northEast = pointOnCircle( drawPosition, startAngle );
-        const QPointF northWest = pointOnCircle( drawPosition, startAngle + angleLen );
+        const QPointF northEast = geometry.northEast;
+        const QPointF northWest = geometry.northWest;
         QPointF center    = (south + north) / 2.0;
         const QPointF east      = (south + northEast) / 2.0;
         const QPointF west      = (south + northWest) / 2.0;
@@ -638,6 +658,33 @@ void PieDiagram::draw3DEffect( QPainter* painter,
     //painter->setBrush( QBrush( threeDAttrs.dataShadow1Color( pie ),
     //            params()->shadowPattern() ) );
 
+    PieSliceGeometry& geometry = d->sliceGeometry[ pie ];
+    if ( !geometry.hasEffect ) {
+        build3DEffect( &geometry.effect, drawPosition, pie, granularity, threeDAttrs );
+        geometry.hasEffect = true;
+    }
+    Q_FOREACH( const PieEffectShape& shape, geometry.effect ) {
+        if ( shape.closed )
+            painter->drawPolygon( shape.polygon );
+        else
+            painter->drawPolyline( shape.polygon );
+    }
+}
+
+
+/**
+  Internal method that collects the polygons creating the 3D effect of a pie
+
+  \param shapes the list to append the polygons to, in painting order
+  \param drawPosition the position to draw at
+  \param pie the pie to build the shadow for
+  */
+void PieDiagram::build3DEffect( PieEffectShapeList* shapes,
+        const QRectF& drawPosition,
+        uint pie,
+        qreal granularity,
+        const ThreeDPieAttributes& threeDAttrs )
+{
     qreal startAngle = d->startAngles[ pie ];
     qreal endAngle = startAngle + d->angleLens[ pie ];
     // Normalize angles
@@ -652,198 +699,198 @@ void PieDiagram::draw3DEffect( QPainter* painter,
 
     if ( startAngle == endAngle ||
             startAngle == endAngle - 360 ) { // full circle
-        drawArcEffectSegment( painter, drawPosition,
+        drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, 360, granularity );
     } else if ( startAngle <= 90 ) {
         if ( endAngle <= 90 ) {
             if ( startAngle <= endAngle ) {
                 /// starts and ends in first quadrant, less than 1/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), startAngle );
-                drawUpperBrinkEffect( painter, drawPosition, endAngle );
+                drawUpperBrinkEffect( shapes, drawPosition, endAngle );
             } else {
                 /// starts and ends in first quadrant, more than 3/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), startAngle );
-                drawUpperBrinkEffect( painter, drawPosition, endAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, endAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     180, 360, granularity );
             }
         } else if ( endAngle <= 180 ) {
             /// starts in first quadrant, ends in second quadrant,
             /// less than 1/2
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
         } else if ( endAngle <= 270 ) {
             /// starts in first quadrant, ends in third quadrant
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, endAngle, granularity );
         } else { // 270*16 < endAngle < 360*16
             /// starts in first quadrant, ends in fourth quadrant,
             /// more than 3/4
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, endAngle, granularity );
         }
     } else if ( startAngle <= 180 ) {
         if ( endAngle <= 90 ) {
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, 360, granularity );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
         } else if ( endAngle <= 180 ) {
             if ( startAngle <= endAngle ) {
                 /// starts in second quadrant, ends in second
                 /// quadrant, less than 1/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), endAngle );
-                drawUpperBrinkEffect( painter, drawPosition, startAngle );
+                drawUpperBrinkEffect( shapes, drawPosition, startAngle );
             } else {
                 /// starts in second quadrant, ends in second
                 /// quadrant, more than 1/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), endAngle );
-                drawUpperBrinkEffect( painter, drawPosition, startAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     180, 360, granularity );
             }
         } else if ( endAngle <= 270 ) {
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, endAngle, granularity );
         } else { // 270*16 < endAngle < 360*16
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, endAngle, granularity );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
         }
     } else if ( startAngle <= 270 ) {
         if ( endAngle <= 90 ) {
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, 360, granularity );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
         } else if ( endAngle <= 180 ) {
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, 360, granularity );
         } else if ( endAngle <= 270 ) {
             if ( startAngle <= endAngle ) {
                 /// starts in third quadrant, ends in third quadrant,
                 /// less than 1/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), endAngle );
-                drawUpperBrinkEffect( painter, drawPosition, startAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     startAngle, endAngle, granularity );
             } else {
                 /// starts in third quadrant, ends in third quadrant,
                 /// more than 3/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), endAngle );
-                drawUpperBrinkEffect( painter, drawPosition, startAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     180, endAngle, granularity );
-                drawArcEffectSegment( painter, drawPosition,
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     startAngle, 360, granularity );
             }
         } else { // 270*16 < endAngle < 360*16
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, endAngle, granularity );
-            drawUpperBrinkEffect( painter, drawPosition, startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, startAngle );
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
         }
     } else { // 270*16 < startAngle < 360*16
         if ( endAngle <= 90 ) {
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawUpperBrinkEffect( painter, drawPosition, endAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawUpperBrinkEffect( shapes, drawPosition, endAngle );
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, 360, granularity );
         } else if ( endAngle <= 180 ) {
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, 360, granularity );
         } else if ( endAngle <= 270 ) {
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), startAngle );
-            drawStraightEffectSegment( painter, drawPosition,
+            drawStraightEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(), endAngle );
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 180, endAngle, granularity );
-            drawArcEffectSegment( painter, drawPosition,
+            drawArcEffectSegment( shapes, drawPosition,
                 threeDAttrs.depth(),
                 startAngle, 360, granularity );
         } else { // 270*16 < endAngle < 360*16
             if ( startAngle <= endAngle ) {
                 /// starts in fourth quadrant, ends in fourth
                 /// quadrant, less than 1/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), startAngle );
-                drawUpperBrinkEffect( painter, drawPosition, endAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, endAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     startAngle, endAngle, granularity );
             } else {
                 /// starts in fourth quadrant, ends in fourth
                 /// quadrant, more than 3/4
-                drawStraightEffectSegment( painter, drawPosition,
+                drawStraightEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(), startAngle );
-                drawUpperBrinkEffect( painter, drawPosition, endAngle );
-                drawArcEffectSegment( painter, drawPosition,
+                drawUpperBrinkEffect( shapes, drawPosition, endAngle );
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     startAngle, 360, granularity );
-                drawArcEffectSegment( painter, drawPosition,
+                drawArcEffectSegment( shapes, drawPosition,
                     threeDAttrs.depth(),
                     180, endAngle, granularity );
             }
         }
     }
-    drawArcUpperBrinkEffectSegment( painter, drawPosition, startAngle, endAngle, granularity );
+    drawArcUpperBrinkEffectSegment( shapes, drawPosition, startAngle, endAngle, granularity );
 }
 
 
 /**
   Internal method that draws a segment with a straight 3D effect
 
-  \param painter the QPainter to draw in
+  \param shapes the list to append the polygon to
   \param rect the position to draw at
   \param threeDHeight the height of the shadow
   \param angle the angle of the segment
   */
-void PieDiagram::drawStraightEffectSegment( QPainter* painter,
+void PieDiagram::drawStraightEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal threeDHeight,
         qreal angle )
@@ -856,7 +903,7 @@ void PieDiagram::drawStraightEffectSegment( QPainter* painter,
     poly[2] = QPointF( circlePoint.x(), circlePoint.y() + threeDHeight );
     poly[3] = QPointF( center.x(), center.y() + threeDHeight );
     // TODO: add polygon to ReverseMapper
-    painter->drawPolygon( poly );
+    shapes->append( PieEffectShape( poly, true ) );
 //    if ( region )
 //        *region += QRegion( points );
 }
@@ -864,29 +911,32 @@ void PieDiagram::drawStraightEffectSegment( QPainter* painter,
 /**
   Internal method that draws the upper brink of a 3D pie piece
 
-  \param painter the QPainter to draw in
+  \param shapes the list to append the polygon to
   \param rect the position to draw at
   \param angle the angle of the segment
   */
-void PieDiagram::drawUpperBrinkEffect( QPainter* painter,
+void PieDiagram::drawUpperBrinkEffect( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal angle )
 {
     const QPointF center = rect.center();
     const QPointF circlePoint = pointOnCircle( rect, angle );
-    painter->drawLine( center, circlePoint );
+    QPolygonF line( 2 );
+    line[0] = center;
+    line[1] = circlePoint;
+    shapes->append( PieEffectShape( line, false ) );
 }
 
 /**
   Internal method that draws a segment with an arc 3D effect
 
-  \param painter the QPainter to draw in
+  \param shapes the list to append the polygon to
   \param rect the position to draw at
   \param threeDHeight the height of the shadow
   \param startAngle the starting angle of the segment
   \param endAngle the ending angle of the segment
   */
-void PieDiagram::drawArcEffectSegment( QPainter* painter,
+void PieDiagram::drawArcEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal threeDHeight,
         qreal startAngle,
@@ -899,7 +949,7 @@ void PieDiagram::drawArcEffectSegment( QPainter* painter,
 
     // sometimes we have to draw two segments, which are on different sides of the pie
     if( endA > 540 )
-        drawArcEffectSegment( painter, rect, threeDHeight, 180, endA - 360, granularity );
+        drawArcEffectSegment( shapes, rect, threeDHeight, 180, endA - 360, granularity );
     if( endA > 360 )
         endA = qMin( endA, qreal( 360.0 ) );
 
@@ -934,7 +984,7 @@ void PieDiagram::drawArcEffectSegment( QPainter* painter,
     }
 
     // TODO: Add polygon to ReverseMapper
-    painter->drawPolygon( poly );
+    shapes->append( PieEffectShape( poly, true ) );
 //    if ( region )
 //        *region += QRegion( collect );
 }
@@ -942,12 +992,12 @@ void PieDiagram::drawArcEffectSegment( QPainter* painter,
 /**
   Internal method that draws the upper brink of a 3D pie segment
 
-  \param painter the QPainter to draw in
+  \param shapes the list to append the polygon to
   \param rect the position to draw at
   \param startAngle the starting angle of the segment
   \param endAngle the ending angle of the segment
   */
-void PieDiagram::drawArcUpperBrinkEffectSegment( QPainter* painter,
+void PieDiagram::drawArcUpperBrinkEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal startAngle,
         qreal endAngle,
@@ -979,7 +1029,7 @@ void PieDiagram::drawArcUpperBrinkEffectSegment( QPainter* painter,
         ++numHalfPoints;
     }
 
-    painter->drawPolyline( poly );
+    shapes->append( PieEffectShape( poly, false ) );
 //    if ( region )
 //        *region += QRegion( collect );
 }
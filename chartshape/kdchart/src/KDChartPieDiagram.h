@@ -29,6 +29,8 @@ namespace KDChart {
 
     class DataValueTextInfo;
     typedef class QVector<DataValueTextInfo> DataValueTextInfoList;
+    class PieEffectShape;
+    typedef class QVector<PieEffectShape> PieEffectShapeList;
 
 /**
   * @brief PieDiagram defines a common pie diagram
@@ -88,20 +90,25 @@ private:
         qreal granularity,
         const ThreeDPieAttributes& threeDAttrs,
         bool /*explode*/ );
-    void drawStraightEffectSegment( QPainter* painter,
+    void build3DEffect( PieEffectShapeList* shapes,
+        const QRectF& drawPosition,
+        uint pie,
+        qreal granularity,
+        const ThreeDPieAttributes& threeDAttrs );
+    void drawStraightEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal threeDHeight,
         qreal angle );
-    void drawUpperBrinkEffect( QPainter* painter,
+    void drawUpperBrinkEffect( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal angle );
-    void drawArcEffectSegment( QPainter* painter,
+    void drawArcEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal threeDHeight,
         qreal startAngle,
         qreal endAngle,
         qreal granularity );
-    void drawArcUpperBrinkEffectSegment( QPainter* painter,
+    void drawArcUpperBrinkEffectSegment( PieEffectShapeList* shapes,
         const QRectF& rect,
         qreal startAngle,
         qreal endAngle,
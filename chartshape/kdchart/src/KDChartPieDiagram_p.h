@@ -36,11 +36,76 @@
 
 #include "KDChartAbstractPieDiagram_p.h"
 
+#include <QPolygonF>
+
 #include <KDABLibFakes>
 
 
 namespace KDChart {
 
+/**
+ * \internal
+ * One polygon of the 3D effect of a pie. Brinks are open lines and
+ * must not be filled.
+ */
+class PieEffectShape
+{
+public:
+    PieEffectShape() : closed( true ) {}
+    PieEffectShape( const QPolygonF& polygon_, bool closed_ )
+        : polygon( polygon_ ), closed( closed_ ) {}
+
+    QPolygonF polygon;
+    bool closed;
+};
+
+/**
+ * \internal
+ * The geometry of one pie, kept across paints for as long as the values
+ * it was computed from stay the same.
+ */
+class PieSliceGeometry
+{
+public:
+    PieSliceGeometry()
+        : startAngle( 0.0 ), angleLen( 0.0 ), granularity( 0.0 ),
+          threeD( false ), depth( 0.0 ),
+          hasEffect( false ), hasSurface( false ) {}
+    PieSliceGeometry( qreal startAngle_, qreal angleLen_,
+                      const QRectF& drawPosition_, qreal granularity_,
+                      bool threeD_, qreal depth_ )
+        : startAngle( startAngle_ ), angleLen( angleLen_ ),
+          drawPosition( drawPosition_ ), granularity( granularity_ ),
+          threeD( threeD_ ), depth( depth_ ),
+          hasEffect( false ), hasSurface( false ) {}
+
+    bool matches( qreal startAngle_, qreal angleLen_,
+                  const QRectF& drawPosition_, qreal granularity_,
+                  bool threeD_, qreal depth_ ) const
+    {
+        return startAngle == startAngle_ && angleLen == angleLen_ &&
+               drawPosition == drawPosition_ && granularity == granularity_ &&
+               threeD == threeD_ && depth == depth_;
+    }
+
+    // the values the geometry was computed from
+    qreal startAngle;
+    qreal angleLen;
+    QRectF drawPosition;
+    qreal granularity;
+    bool threeD;
+    qreal depth;
+
+    bool hasEffect;
+    PieEffectShapeList effect;
+    bool hasSurface;
+    QPolygonF surface;
+    // anchors of the data value text
+    QPointF north;
+    QPointF northEast;
+    QPointF northWest;
+};
+
 /**
  * \internal
  */
@@ -63,6 +128,8 @@ protected:
     QVector < qreal > angleLens;
     QRectF position;
     qreal size;
+    // one per pie, rebuilt when its angles, position or 3D depth change
+    QVector < PieSliceGeometry > sliceGeometry;
 };
 
 KDCHART_IMPL_DERIVED_DIAGRAM( PieDiagram, AbstractPieDiagram, PolarCoordinatePlane )
@@ -229,6 +229,29 @@ void RingDiagram::paint( PaintContext* ctx )
     d->position = QRectF( x, y, d->size, d->size );
     d->position.translate( contentsRect.left(), contentsRect.top() );
 
+    // sum up the radial gaps and explode factors of the outer rings once
+    // here, rather than once for every single pie of the inner rings
+    d->outerRadialGaps = QVector< qreal >( rCount, 0.0 );
+    d->outerRadialExplodes = QVector< qreal >( rCount, 0.0 );
+    if ( d->expandWhenExploded ) {
+        for( int i = rCount - 1; i > 0; --i ){
+            qreal maxRadialExplodeInThisRow = 0.0;
+            qreal maxRadialGapInThisRow = 0.0;
+            for( int j = 0; j < colCount; ++j ){
+                const PieAttributes cellAttrs( pieAttributes( model()->index( i, j, rootIndex() ) ) );
+                maxRadialGapInThisRow = qMax( maxRadialGapInThisRow, cellAttrs.gapFactor( false ) );
+                if ( cellAttrs.explode() )
+                    maxRadialExplodeInThisRow = qMax( maxRadialExplodeInThisRow, cellAttrs.explodeFactor() );
+            }
+            d->outerRadialGaps[ i - 1 ] = d->outerRadialGaps[ i ] + maxRadialGapInThisRow;
+            d->outerRadialExplodes[ i - 1 ] = d->outerRadialExplodes[ i ] + maxRadialExplodeInThisRow;
+        }
+    }
+
+    d->sliceGeometry.resize( rCount );
+    for ( int iRow = 0; iRow < rCount; ++iRow )
+        d->sliceGeometry[ iRow ].resize( colCount );
+
     const PolarCoordinatePlane * plane = polarCoordinatePlane();
 
     bool atLeastOneValue = false; // guard against completely empty tables
@@ -320,7 +343,6 @@ void RingDiagram::drawPieSurface( QPainter* painter,
         const PieAttributes attrs( pieAttributes( index ) );
 
     	const int rCount = rowCount();
-    	const int colCount = columnCount();
 
     	int iPoint = 0;
 
@@ -347,86 +369,70 @@ void RingDiagram::drawPieSurface( QPainter* painter,
 	            //qDebug() << "gapFactor=" << attrs.gapFactor( false );
             }
 
-            QPolygonF poly;
-
-            qreal degree = 0;
-
             qreal actualStartAngle = startAngle + circularGap;
             qreal actualAngleLen = angleLen - 2 * circularGap;
 
-            qreal totalRadialExplode = 0.0;
-            qreal maxRadialExplode = 0.0;
-
-            qreal totalRadialGap = 0.0;
-            qreal maxRadialGap = 0.0;
-            for( uint i = rCount - 1; i > dataset; --i ){
-            	qreal maxRadialExplodeInThisRow = 0.0;
-            	qreal maxRadialGapInThisRow = 0.0;
-            	for( int j = 0; j < colCount; ++j ){
-            		const PieAttributes cellAttrs( pieAttributes( model()->index( i, j, rootIndex() ) ) );
-            		//qDebug() << cellAttrs.explodeFactor();
-            		if ( d->expandWhenExploded )
-            			maxRadialGapInThisRow = qMax( maxRadialGapInThisRow, cellAttrs.gapFactor( false ) );
-            		if ( !cellAttrs.explode() )
-            			continue;
-            		// Don't use a gap for the very inner circle
-                	if ( d->expandWhenExploded )
-                		maxRadialExplodeInThisRow = qMax( maxRadialExplodeInThisRow, cellAttrs.explodeFactor() );
-            	}
-            	maxRadialExplode += maxRadialExplodeInThisRow;
-            	maxRadialGap += maxRadialGapInThisRow;
-
-            	// FIXME: What if explode factor of inner ring is > 1.0 ?
-            	//if ( !d->expandWhenExploded )
-            	//	break;
-            }
-
-            totalRadialGap = maxRadialGap + attrs.gapFactor( false );
-            totalRadialExplode = attrs.explode() ? maxRadialExplode + attrs.explodeFactor() : maxRadialExplode;
-
-            while ( degree <= actualAngleLen ) {
-            	const QPointF p = pointOnCircle( drawPosition, dataset, pie, false, actualStartAngle + degree, totalRadialGap, totalRadialExplode );
-                poly.append( p );
-                degree += granularity;
-                iPoint++;
-            }
-            if( ! perfectMatch ){
-                poly.append( pointOnCircle( drawPosition, dataset, pie, false, actualStartAngle + actualAngleLen, totalRadialGap, totalRadialExplode ) );
-                iPoint++;
+            const qreal maxRadialExplode = d->outerRadialExplodes[ dataset ];
+            const qreal maxRadialGap = d->outerRadialGaps[ dataset ];
+
+            const qreal totalRadialGap = maxRadialGap + attrs.gapFactor( false );
+            const qreal totalRadialExplode = attrs.explode() ? maxRadialExplode + attrs.explodeFactor() : maxRadialExplode;
+
+            const RingSliceGeometry key( startAngle, angleLen, drawPosition, granularity,
+                                         circularGap, totalRadialGap, totalRadialExplode, rCount );
+            RingSliceGeometry& geometry = d->sliceGeometry[ dataset ][ pie ];
+            if ( geometry != key ) {
+                geometry = key;
+
+                QPolygonF poly;
+
+                qreal degree = 0;
+
+                while ( degree <= actualAngleLen ) {
+                    const QPointF p = pointOnCircle( drawPosition, dataset, pie, false, actualStartAngle + degree, totalRadialGap, totalRadialExplode );
+                    poly.append( p );
+                    degree += granularity;
+                    iPoint++;
+                }
+                if( ! perfectMatch ){
+                    poly.append( pointOnCircle( drawPosition, dataset, pie, false, actualStartAngle + actualAngleLen, totalRadialGap, totalRadialExplode ) );
+                    iPoint++;
+                }
+
+                // The center point of the inner brink
+                const QPointF innerCenterPoint( poly[ int(iPoint / 2) ] );
+
+                actualStartAngle = startAngle + circularGap;
+                actualAngleLen = angleLen - 2 * circularGap;
+
+                degree = actualAngleLen;
+
+                const int lastInnerBrinkPoint = iPoint;
+                while ( degree >= 0 ){
+                    poly.append( pointOnCircle( drawPosition, dataset, pie, true, actualStartAngle + degree, totalRadialGap, totalRadialExplode ) );
+                    perfectMatch = (degree == 0);
+                    degree -= granularity;
+                    iPoint++;
+                }
+                // if necessary add one more point to fill the last small gap
+                if( ! perfectMatch ){
+                    poly.append( pointOnCircle( drawPosition, dataset, pie, true, actualStartAngle, totalRadialGap, totalRadialExplode ) );
+                    iPoint++;
+                }
+
+                // The center point of the outer brink
+                const QPointF outerCenterPoint( poly[ lastInnerBrinkPoint + int((iPoint - lastInnerBrinkPoint) / 2) ] );
+
+                geometry.polygon = poly;
+                geometry.center = (innerCenterPoint + outerCenterPoint) / 2.0;
             }
-
-            // The center point of the inner brink
-            const QPointF innerCenterPoint( poly[ int(iPoint / 2) ] );
-	    
-            actualStartAngle = startAngle + circularGap;
-            actualAngleLen = angleLen - 2 * circularGap;
-
-            degree = actualAngleLen;
-
-            const int lastInnerBrinkPoint = iPoint;
-            while ( degree >= 0 ){
-                poly.append( pointOnCircle( drawPosition, dataset, pie, true, actualStartAngle + degree, totalRadialGap, totalRadialExplode ) );
-                perfectMatch = (degree == 0);
-                degree -= granularity;
-                iPoint++;
-            }
-            // if necessary add one more point to fill the last small gap
-            if( ! perfectMatch ){
-                poly.append( pointOnCircle( drawPosition, dataset, pie, true, actualStartAngle, totalRadialGap, totalRadialExplode ) );
-                iPoint++;
-            }
-
-            // The center point of the outer brink
-            const QPointF outerCenterPoint( poly[ lastInnerBrinkPoint + int((iPoint - lastInnerBrinkPoint) / 2) ] );
             //qDebug() << poly;
             //find the value and paint it
             //fix value position
             const qreal sum = valueTotals( dataset );
-            painter->drawPolygon( poly );
-
-            const QPointF centerPoint = (innerCenterPoint + outerCenterPoint) / 2.0;
+            painter->drawPolygon( geometry.polygon );
 
-            paintDataValueText( painter, index, centerPoint, angleLen*sum / 360  );
+            paintDataValueText( painter, index, geometry.center, angleLen*sum / 360  );
 
         }
     }
@@ -36,11 +36,58 @@
 
 #include "KDChartAbstractPieDiagram_p.h"
 
+#include <QPolygonF>
+
 #include <KDABLibFakes>
 
 
 namespace KDChart {
 
+/**
+ * \internal
+ * The polygon of one pie of a ring, kept across paints for as long as
+ * the values it was computed from stay the same.
+ */
+class RingSliceGeometry
+{
+public:
+    RingSliceGeometry()
+        : startAngle( 0.0 ), angleLen( 0.0 ), granularity( 0.0 ),
+          circularGap( 0.0 ), radialGap( 0.0 ), radialExplode( 0.0 ),
+          rowCount( -1 ) {}
+    RingSliceGeometry( qreal startAngle_, qreal angleLen_,
+                       const QRectF& position_, qreal granularity_,
+                       qreal circularGap_, qreal radialGap_,
+                       qreal radialExplode_, int rowCount_ )
+        : startAngle( startAngle_ ), angleLen( angleLen_ ),
+          position( position_ ), granularity( granularity_ ),
+          circularGap( circularGap_ ), radialGap( radialGap_ ),
+          radialExplode( radialExplode_ ), rowCount( rowCount_ ) {}
+
+    bool operator==( const RingSliceGeometry& other ) const
+    {
+        return startAngle == other.startAngle && angleLen == other.angleLen &&
+               position == other.position && granularity == other.granularity &&
+               circularGap == other.circularGap && radialGap == other.radialGap &&
+               radialExplode == other.radialExplode && rowCount == other.rowCount;
+    }
+    bool operator!=( const RingSliceGeometry& other ) const { return !( *this == other ); }
+
+    // the values the geometry was computed from
+    qreal startAngle;
+    qreal angleLen;
+    QRectF position;
+    qreal granularity;
+    qreal circularGap;
+    qreal radialGap;
+    qreal radialExplode;
+    int rowCount;
+
+    QPolygonF polygon;
+    // anchor of the data value text
+    QPointF center;
+};
+
 /**
  * \internal
  */
@@ -68,6 +115,11 @@ protected:
     bool expandWhenExploded;
     // polygons associated to their 3d depth
     QMap<qreal, QPolygon> polygonsToRender;
+    // summed up radial gaps and explode factors of the rings outside of each ring
+    QVector< qreal > outerRadialGaps;
+    QVector< qreal > outerRadialExplodes;
+    // one per pie, rebuilt when the key values of the pie change
+    QVector< QVector< RingSliceGeometry > > sliceGeometry;
 };
 
 KDCHART_IMPL_DERIVED_DIAGRAM( RingDiagram, AbstractPieDiagram, PolarCoordinatePlane )
@@ -53,17 +53,10 @@ const QPair<QPointF, QPointF> StackedBarDiagram::calculateDataBoundaries() const
     for( int row = 0; row < rowCount; ++row )
     {
         // calculate sum of values per column - Find out stacked Min/Max
-        double stackedValues = 0.0;
-        double negativeStackedValues = 0.0;
         for ( int col = 0; col < colCount ; ++col )
         {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-
-            if( point.value > 0.0 )
-                stackedValues += point.value;
-            else
-                negativeStackedValues += point.value;
+            const double stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::PositiveValues );
+            const double negativeStackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::NegativeValues );
 
             // this is always true yMin can be 0 in case all values
             // are the same
@@ -176,14 +169,12 @@ void StackedBarDiagram::paint(  PaintContext* ctx )
             } else
                 barWidth =  (width - (offset*rowCount))/ rowCount ;
 
-            for ( int k = col; k >= 0; --k )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( row, k );
-                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                if( ( p.value >= 0.0 && point.value >= 0.0 ) || ( p.value < 0.0 && point.value < 0.0 ) )
-                    stackedValues += point.value;
-                key = point.key;
-            }
+            // values of the same sign are stacked onto each other
+            if( p.value >= 0.0 )
+                stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::PositiveValues );
+            else if( p.value < 0.0 )
+                stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::NegativeValues );
+            key = compressor().data( CartesianDiagramDataCompressor::CachePosition( row, 0 ) ).key;
             QPointF point = ctx->coordinatePlane()->translate( QPointF( key, stackedValues ) );
             point.rx() += offset / 2;
             const QPointF previousPoint = ctx->coordinatePlane()->translate( QPointF( key, stackedValues - value ) );
@@ -196,5 +187,6 @@ void StackedBarDiagram::paint(  PaintContext* ctx )
             paintBars( ctx, index, rect, maxDepth );
         }
     }
+    paintBatchedBars( ctx );
     paintDataValueTextsAndMarkers( diagram(), ctx, list, false );
 }
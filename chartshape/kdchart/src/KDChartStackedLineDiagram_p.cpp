@@ -46,7 +46,6 @@ LineDiagram::LineType StackedLineDiagram::type() const
 const QPair<QPointF, QPointF> StackedLineDiagram::calculateDataBoundaries() const
 {
     const int rowCount = compressor().modelDataRows();
-    const int colCount = compressor().modelDataColumns();
     const double xMin = 0;
     double xMax = diagram()->model() ? diagram()->model()->rowCount( diagram()->rootIndex() ) : 0;
     if ( !diagram()->centerDataPoints() && diagram()->model() )
@@ -57,20 +56,8 @@ const QPair<QPointF, QPointF> StackedLineDiagram::calculateDataBoundaries() cons
     for( int row = 0; row < rowCount; ++row )
     {
         // calculate sum of values per column - Find out stacked Min/Max
-        double stackedValues = 0.0;
-        double negativeStackedValues = 0.0;
-        for( int col = datasetDimension() - 1; col < colCount; col += datasetDimension() ) {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-
-            if( ISNAN( point.value ) )
-                continue;
-
-            if( point.value >= 0.0 )
-                stackedValues += point.value;
-            else
-                negativeStackedValues += point.value;
-        }
+        const double stackedValues = compressor().stackedTotal( row, CartesianDiagramDataCompressor::PositiveValues );
+        const double negativeStackedValues = compressor().stackedTotal( row, CartesianDiagramDataCompressor::NegativeValues );
 
         if( bStarting ){
             yMin = stackedValues;
@@ -132,13 +119,14 @@ void StackedLineDiagram::paint(  PaintContext* ctx )
         QModelIndex indexPreviousCell;
         QList<QPolygonF> areas;
         QList<QPointF> points;
+        AttributesSpanCursor<LineAttributes> lineAttrs;
 
         for ( int row = 0; row < rowCount; ++row ) {
             const CartesianDiagramDataCompressor::CachePosition position( row, column );
             CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
             const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
 
-            const LineAttributes laCell = diagram()->lineAttributes( sourceIndex );
+            const LineAttributes laCell = cellAttributes( lineAttrs, sourceIndex, LineAttributesRole );
             const bool bDisplayCellArea = laCell.displayArea();
 
             const LineAttributes::MissingValuesPolicy policy = laCell.missingValuesPolicy();
@@ -146,39 +134,12 @@ void StackedLineDiagram::paint(  PaintContext* ctx )
             if( ISNAN( point.value ) && policy == LineAttributes::MissingValuesShownAsZero )
                 point.value = 0.0;
 
-            double stackedValues = 0, nextValues = 0, nextKey = 0;
-            for ( int column2 = column; column2 >= 0; --column2 )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( row, column2 );
-                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                const QModelIndex sourceIndex = attributesModel()->mapToSource( point.index );
-                if( !ISNAN( point.value ) )
-                {
-                    stackedValues += point.value;
-                }
-                else if( policy == LineAttributes::MissingValuesAreBridged )
-                {
-                    const double interpolation = interpolateMissingValue( position );
-                    if( !ISNAN( interpolation ) )
-                        stackedValues += interpolation;
-                }
-
-                //qDebug() << valueForCell( iRow, iColumn2 );
-                if ( row + 1 < rowCount ){
-                    const CartesianDiagramDataCompressor::CachePosition position( row + 1, column2 );
-                    const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                    if( !ISNAN( point.value ) )
-                    {
-                        nextValues += point.value;
-                    }
-                    else if( policy == LineAttributes::MissingValuesAreBridged )
-                    {
-                        const double interpolation = interpolateMissingValue( position );
-                        if( !ISNAN( interpolation ) )
-                            nextValues += interpolation;
-                    }
-                    nextKey = point.key;
-                }
+            const bool bridged = policy == LineAttributes::MissingValuesAreBridged;
+            const double stackedValues = stackedValue( row, column, bridged, false );
+            double nextValues = 0, nextKey = 0;
+            if ( row + 1 < rowCount ){
+                nextValues = stackedValue( row + 1, column, bridged, false );
+                nextKey = compressor().data( CartesianDiagramDataCompressor::CachePosition( row + 1, 0 ) ).key;
             }
             //qDebug() << stackedValues << endl;
             const QPointF nextPoint = ctx->coordinatePlane()->translate( QPointF( diagram()->centerDataPoints() ? point.key + 0.5 : point.key, stackedValues ) );
@@ -53,17 +53,10 @@ const QPair<QPointF, QPointF> StackedLyingBarDiagram::calculateDataBoundaries()
     for( int row = 0; row < rowCount; ++row )
     {
         // calculate sum of values per column - Find out stacked Min/Max
-        double stackedValues = 0.0;
-        double negativeStackedValues = 0.0;
         for ( int col = 0; col < colCount ; ++col )
         {
-            const CartesianDiagramDataCompressor::CachePosition position( row, col );
-            const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-
-            if( point.value > 0.0 )
-                stackedValues += point.value;
-            else
-                negativeStackedValues += point.value;
+            const double stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::PositiveValues );
+            const double negativeStackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::NegativeValues );
 
             // this is always true yMin can be 0 in case all values
             // are the same
@@ -180,14 +173,12 @@ void StackedLyingBarDiagram::paint(  PaintContext* ctx )
                 barWidth = (width - (offset*rowCount))/ rowCount;
             }
 
-            for ( int k = col; k >= 0; --k )
-            {
-                const CartesianDiagramDataCompressor::CachePosition position( row, k );
-                const CartesianDiagramDataCompressor::DataPoint point = compressor().data( position );
-                if( ( p.value >= 0.0 && point.value >= 0.0 ) || ( p.value < 0.0 && point.value < 0.0 ) )
-                    stackedValues += point.value;
-                key = point.key;
-            }
+            // values of the same sign are stacked onto each other
+            if( p.value >= 0.0 )
+                stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::PositiveValues );
+            else if( p.value < 0.0 )
+                stackedValues = compressor().stackedValue( row, col, CartesianDiagramDataCompressor::NegativeValues );
+            key = compressor().data( CartesianDiagramDataCompressor::CachePosition( row, 0 ) ).key;
             QPointF point = ctx->coordinatePlane()->translate( QPointF( stackedValues, rowCount - key ) );
             point.ry() += offset / 2 + threeDOffset;
             const QPointF previousPoint = ctx->coordinatePlane()->translate( QPointF( stackedValues - value, rowCount - key ) );
@@ -201,5 +192,6 @@ void StackedLyingBarDiagram::paint(  PaintContext* ctx )
             paintBars( ctx, index, rect, maxDepth );
         }
     }
+    paintBatchedBars( ctx );
     paintDataValueTextsAndMarkers( diagram(), ctx, list, false );
 }
@@ -24,6 +24,9 @@
 #include "KDChartStockDiagram_p.h"
 
 #include "KDChartPaintContext.h"
+#include "KDChartCartesianCoordinatePlane.h"
+
+#include <KDABLibFakes>
 
 using namespace KDChart;
 
@@ -57,6 +60,9 @@ void StockDiagram::init()
     d->lowHighLinePen = QPen( Qt::black );
 
     setPen( QPen( Qt::black ) );
+
+    // The aggregated bars are dropped together with the data boundaries
+    connect( this, SIGNAL( modelDataChanged() ), this, SLOT( setDataBoundariesDirty() ) );
 }
 
 /**
@@ -66,6 +72,8 @@ void StockDiagram::init()
 void StockDiagram::setType( Type type )
 {
     d->type = type;
+    // The columns of the values depend on the type
+    d->aggregatedBars.clear();
     emit propertiesChanged();
 }
 
@@ -77,6 +85,31 @@ StockDiagram::Type StockDiagram::type() const
    return d->type;
 }
 
+/**
+  * Sets whether bars narrower than a pixel are merged, so that at most
+  * one bar is drawn per pixel. A merged bar shows the first open value,
+  * the highest high value, the lowest low value and the last close value
+  * of the bars it stands for.
+  *
+  * The merged bars are cached for each zoom level until the data changes.
+  * This is disabled by default.
+  */
+void StockDiagram::setAggregateBarsPerPixel( bool aggregate )
+{
+    d->aggregateBarsPerPixel = aggregate;
+    if ( !aggregate )
+        d->aggregatedBars.clear();
+    emit propertiesChanged();
+}
+
+/**
+  * @return whether bars narrower than a pixel are merged
+  */
+bool StockDiagram::aggregateBarsPerPixel() const
+{
+    return d->aggregateBarsPerPixel;
+}
+
 void StockDiagram::setStockBarAttributes( const StockBarAttributes &attr )
 {
     attributesModel()->setModelData(
@@ -290,6 +323,32 @@ void StockDiagram::paint( PaintContext *context )
     d->reverseMapper.clear();
 
     PainterSaver painterSaver( context->painter() );
+
+    const int barsPerBucket = d->aggregateBarsPerPixel ? d->barsPerBucket( context ) : 1;
+    if ( barsPerBucket > 1 ) {
+        const QVector< Private::AggregatedBar >& bars = d->aggregates( barsPerBucket );
+        // Only the buckets overlapping the visible range of keys are
+        // painted, plus one on each side for bars wider than their bucket
+        qreal firstBucket = 0.0;
+        qreal lastBucket = bars.size() - 1;
+        const CartesianCoordinatePlane* const plane = dynamic_cast< CartesianCoordinatePlane* >( context->coordinatePlane() );
+        if ( plane ) {
+            const QRectF visibleRange = plane->visibleDataRange();
+            const qreal minKey = qMin( visibleRange.left(), visibleRange.right() );
+            const qreal maxKey = qMax( visibleRange.left(), visibleRange.right() );
+            if ( !ISNAN( minKey ) && !ISNAN( maxKey ) ) {
+                firstBucket = qMax( firstBucket, qreal( floor( minKey / barsPerBucket ) - 1.0 ) );
+                lastBucket = qMin( lastBucket, qreal( floor( maxKey / barsPerBucket ) + 1.0 ) );
+            }
+        }
+        if ( firstBucket > lastBucket )
+            return;
+        // A merged bar spans its whole bucket
+        for ( int i = static_cast< int >( firstBucket ); i <= lastBucket; ++i )
+            d->drawBar( bars[ i ].open, bars[ i ].high, bars[ i ].low, bars[ i ].close, context, barsPerBucket );
+        return;
+    }
+
     int rowCount = attributesModel()->rowCount( attributesModelRootIndex() );
     for ( int row = 0; row < rowCount; row++ ) {
         CartesianDiagramDataCompressor::DataPoint low;
@@ -316,17 +375,7 @@ void StockDiagram::paint( PaintContext *context )
             close = d->compressor.data( closePos );
         }
 
-        switch( d->type ) {
-        case HighLowClose:
-            open.hidden = true;
-            // Fall-through intended!
-        case OpenHighLowClose:
-            d->drawOHLCBar( open, high, low, close, context );
-            break;
-        case Candlestick:
-            d->drawCandlestick( open, high, low, close, context );
-            break;
-        }
+        d->drawBar( open, high, low, close, context );
     }
 }
 
@@ -353,6 +402,9 @@ double StockDiagram::threeDItemDepth( const QModelIndex &index ) const
 
 const QPair<QPointF, QPointF> StockDiagram::calculateDataBoundaries() const
 {
+    // The boundaries are recalculated whenever the data has changed
+    d->aggregatedBars.clear();
+
     const int rowCount = attributesModel()->rowCount( attributesModelRootIndex() );
     const int colCount = attributesModel()->columnCount( attributesModelRootIndex() );
     qreal xMin = 0.0;
@@ -52,6 +52,9 @@ public:
     void setType( Type type );
     Type type() const;
 
+    void setAggregateBarsPerPixel( bool aggregate );
+    bool aggregateBarsPerPixel() const;
+
     void setStockBarAttributes( const StockBarAttributes &attr );
     StockBarAttributes stockBarAttributes() const;
 
@@ -222,11 +222,13 @@ QPolygonF StockDiagram::Private::ThreeDPainter::drawThreeDRect( const QRectF &re
 
 StockDiagram::Private::Private()
     : AbstractCartesianDiagram::Private()
+    , aggregateBarsPerPixel( false )
 {
 }
 
 StockDiagram::Private::Private( const Private& r )
     : AbstractCartesianDiagram::Private( r )
+    , aggregateBarsPerPixel( r.aggregateBarsPerPixel )
 {
 }
 
@@ -234,6 +236,142 @@ StockDiagram::Private::~Private()
 {
 }
 
+/**
+ * Returns whether a data point has a value to draw
+ */
+static bool isDrawable( const CartesianDiagramDataCompressor::DataPoint &point )
+{
+    return !point.hidden && !ISNAN( point.value );
+}
+
+/**
+ * Merges the following bar into this one, keeping the first open value,
+ * the highest high value, the lowest low value and the last close value
+ *
+ * @param next The bar following this one
+ */
+void StockDiagram::Private::AggregatedBar::append( const AggregatedBar &next )
+{
+    if ( !isDrawable( open ) )
+        open = next.open;
+    if ( isDrawable( next.high ) && ( !isDrawable( high ) || next.high.value > high.value ) )
+        high = next.high;
+    if ( isDrawable( next.low ) && ( !isDrawable( low ) || next.low.value < low.value ) )
+        low = next.low;
+    if ( isDrawable( next.close ) || !isDrawable( close ) )
+        close = next.close;
+}
+
+/**
+ * Places all points of this bar at the same key, so that a bar merged
+ * from several ones is drawn as one
+ *
+ * @param key The key to place the bar at
+ */
+void StockDiagram::Private::AggregatedBar::setKey( qreal key )
+{
+    open.key = key;
+    high.key = key;
+    low.key = key;
+    close.key = key;
+}
+
+/**
+ * Returns the number of bars in the diagram, one per row of the model
+ */
+int StockDiagram::Private::barCount() const
+{
+    return attributesModel->rowCount( attributesModel->mapFromSource( diagram->rootIndex() ) );
+}
+
+/**
+ * Returns the number of bars to merge into one, so that each merged bar
+ * is at least one pixel wide
+ *
+ * @param context The context the bars are painted in
+ * @return The number of bars per bucket, a power of two
+ */
+int StockDiagram::Private::barsPerBucket( PaintContext *context ) const
+{
+    const qreal pixelsPerBar = qAbs( context->coordinatePlane()->translate( QPointF( 1.0, 0.0 ) ).x() -
+                                     context->coordinatePlane()->translate( QPointF( 0.0, 0.0 ) ).x() );
+    const int rowCount = barCount();
+    if ( pixelsPerBar <= 0.0 || ISNAN( pixelsPerBar ) )
+        return 1;
+
+    int bars = 1;
+    while ( bars * pixelsPerBar < 1.0 && bars < rowCount )
+        bars *= 2;
+    return bars;
+}
+
+/**
+ * Returns the bars merged into buckets of \a barsPerBucket consecutive
+ * bars. They are built from the buckets of half the size, which are
+ * kept as well, so switching between zoom levels is cheap.
+ *
+ * @param barsPerBucket The number of bars per bucket, a power of two
+ * @return The merged bars
+ */
+const QVector< StockDiagram::Private::AggregatedBar >& StockDiagram::Private::aggregates( int barsPerBucket ) const
+{
+    QHash< int, QVector< AggregatedBar > >::const_iterator it = aggregatedBars.constFind( barsPerBucket );
+    if ( it != aggregatedBars.constEnd() )
+        return it.value();
+
+    QVector< AggregatedBar > buckets;
+    if ( barsPerBucket <= 1 ) {
+        const int rowCount = barCount();
+        buckets.resize( rowCount );
+        for ( int row = 0; row < rowCount; ++row ) {
+            AggregatedBar &bar = buckets[ row ];
+            // HighLowClose diagrams have no open values
+            if ( openValueColumn() >= 0 )
+                bar.open = compressor.modelDataPoint( row, openValueColumn() );
+            else
+                bar.open.hidden = true;
+            bar.high = compressor.modelDataPoint( row, highValueColumn() );
+            bar.low = compressor.modelDataPoint( row, lowValueColumn() );
+            bar.close = compressor.modelDataPoint( row, closeValueColumn() );
+        }
+    } else {
+        const QVector< AggregatedBar > halves = aggregates( barsPerBucket / 2 );
+        buckets.resize( ( halves.size() + 1 ) / 2 );
+        for ( int i = 0; i < buckets.size(); ++i ) {
+            AggregatedBar &bar = buckets[ i ];
+            bar = halves[ 2 * i ];
+            if ( 2 * i + 1 < halves.size() )
+                bar.append( halves[ 2 * i + 1 ] );
+            // the middle of the bars of the bucket
+            bar.setKey( i * barsPerBucket + ( barsPerBucket - 1 ) / 2.0 );
+        }
+    }
+    return aggregatedBars[ barsPerBucket ] = buckets;
+}
+
+/**
+ * Draws the bar of the diagram's type for the given data points, with its
+ * width scaled by \a widthFactor
+ */
+void StockDiagram::Private::drawBar( CartesianDiagramDataCompressor::DataPoint open,
+                                     const CartesianDiagramDataCompressor::DataPoint &high,
+                                     const CartesianDiagramDataCompressor::DataPoint &low,
+                                     const CartesianDiagramDataCompressor::DataPoint &close,
+                                     PaintContext *context, qreal widthFactor )
+{
+    switch( type ) {
+    case HighLowClose:
+        open.hidden = true;
+        // Fall-through intended!
+    case OpenHighLowClose:
+        drawOHLCBar( open, high, low, close, context, widthFactor );
+        break;
+    case Candlestick:
+        drawCandlestick( open, high, low, close, context, widthFactor );
+        break;
+    }
+}
+
 /**
  * Projects a point onto the coordinate plane
  *
@@ -266,14 +404,14 @@ void StockDiagram::Private::drawOHLCBar( const CartesianDiagramDataCompressor::D
         const CartesianDiagramDataCompressor::DataPoint &high,
         const CartesianDiagramDataCompressor::DataPoint &low,
         const CartesianDiagramDataCompressor::DataPoint &close,
-        PaintContext *context )
+        PaintContext *context, qreal widthFactor )
 {
     // Note: A row in the model is a column in a StockDiagram
     const int col = low.index.row();
 
     StockBarAttributes attr = diagram->stockBarAttributes( col );
     ThreeDBarAttributes threeDAttr = diagram->threeDBarAttributes( col );
-    const qreal tickLength = attr.tickLength();
+    const qreal tickLength = attr.tickLength() * widthFactor;
 
     const QPointF leftOpenPoint( open.key + 0.5 - tickLength, open.value );
     const QPointF rightOpenPoint( open.key + 0.5, open.value );
@@ -337,7 +475,7 @@ void StockDiagram::Private::drawCandlestick( const CartesianDiagramDataCompresso
                                              const CartesianDiagramDataCompressor::DataPoint &high,
                                              const CartesianDiagramDataCompressor::DataPoint &low,
                                              const CartesianDiagramDataCompressor::DataPoint &close,
-                                             PaintContext *context )
+                                             PaintContext *context, qreal widthFactor )
 {
     PainterSaver painterSaver( context->painter() );
 
@@ -382,7 +520,7 @@ void StockDiagram::Private::drawCandlestick( const CartesianDiagramDataCompresso
 
     // Convert the data point into coordinates on the coordinate plane
     QRectF candlestick = projectCandlestick( context, bottomCandlestickPoint,
-                                             topCandlestickPoint, attr.candlestickWidth() );
+                                             topCandlestickPoint, attr.candlestickWidth() * widthFactor );
 
     // Remember the drawn polygon to add it to the ReverseMapper later
     QPolygonF drawnPolygon;
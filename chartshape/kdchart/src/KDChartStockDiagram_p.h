@@ -28,6 +28,8 @@
 #include "KDChartCartesianDiagramDataCompressor_p.h"
 #include "KDChartPaintContext.h"
 
+#include <QHash>
+
 namespace KDChart {
 
 class StockDiagram::Private : public AbstractCartesianDiagram::Private
@@ -55,12 +57,42 @@ public:
     QPen lowHighLinePen;
     QMap<int, QPen> lowHighLinePens;
 
+    // One bar standing for a bucket of consecutive bars
+    class AggregatedBar {
+    public:
+        CartesianDiagramDataCompressor::DataPoint open;
+        CartesianDiagramDataCompressor::DataPoint high;
+        CartesianDiagramDataCompressor::DataPoint low;
+        CartesianDiagramDataCompressor::DataPoint close;
+
+        // merges the following bar into this one
+        void append( const AggregatedBar &next );
+        // places all points of this bar at the same key
+        void setKey( qreal key );
+    };
+
+    bool aggregateBarsPerPixel;
+    // the aggregated bars of each zoom level, keyed by the number of
+    // bars per bucket, which is always a power of two
+    mutable QHash< int, QVector< AggregatedBar > > aggregatedBars;
+
+    int barCount() const;
+    // number of bars per bucket so that each bucket is at least one pixel wide
+    int barsPerBucket( PaintContext *context ) const;
+    const QVector< AggregatedBar >& aggregates( int barsPerBucket ) const;
+
+    // widthFactor scales the width of the bar, e.g. to span a bucket
+    void drawBar( CartesianDiagramDataCompressor::DataPoint open,
+                  const CartesianDiagramDataCompressor::DataPoint &high,
+                  const CartesianDiagramDataCompressor::DataPoint &low,
+                  const CartesianDiagramDataCompressor::DataPoint &close,
+                  PaintContext *context, qreal widthFactor = 1.0 );
 
     void drawOHLCBar( const CartesianDiagramDataCompressor::DataPoint &open,
                       const CartesianDiagramDataCompressor::DataPoint &high,
                       const CartesianDiagramDataCompressor::DataPoint &low,
                       const CartesianDiagramDataCompressor::DataPoint &close,
-                      PaintContext *context );
+                      PaintContext *context, qreal widthFactor = 1.0 );
     void drawHLCBar( const CartesianDiagramDataCompressor::DataPoint &high,
                      const CartesianDiagramDataCompressor::DataPoint &low,
                      const CartesianDiagramDataCompressor::DataPoint &close,
@@ -69,7 +101,7 @@ public:
                           const CartesianDiagramDataCompressor::DataPoint &high,
                           const CartesianDiagramDataCompressor::DataPoint &low,
                           const CartesianDiagramDataCompressor::DataPoint &close,
-                          PaintContext *context );
+                          PaintContext *context, qreal widthFactor = 1.0 );
 
 private:
     void drawLine( int col, const QPointF &point1, const QPointF &p2, PaintContext *context );
@@ -39,6 +39,9 @@ using namespace KDChart;
 using namespace std;
 
 LeveyJenningsDiagram::Private::Private()
+    : calculatedMeanValue( 0.0 ),
+      calculatedStandardDeviation( 0.0 ),
+      timeBoundsDirty( false )
 {
 }
 
@@ -315,11 +318,11 @@ void LeveyJenningsDiagram::setModel( QAbstractItemModel* model )
     if( this->model() != 0 )
     {
         disconnect( this->model(), SIGNAL( dataChanged( const QModelIndex&, const QModelIndex& ) ),
-                                   this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                   this, SLOT( slotDataChanged( const QModelIndex&, const QModelIndex& ) ) );
         disconnect( this->model(), SIGNAL( rowsInserted( const QModelIndex&, int, int ) ),
-                                   this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                   this, SLOT( slotRowsInserted( const QModelIndex&, int, int ) ) );
         disconnect( this->model(), SIGNAL( rowsRemoved( const QModelIndex&, int, int ) ),
-                                   this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                   this, SLOT( slotRowsRemoved( const QModelIndex&, int, int ) ) );
         disconnect( this->model(), SIGNAL( columnsInserted( const QModelIndex&, int, int ) ),
                                    this, SLOT( calculateMeanAndStandardDeviation() ) );
         disconnect( this->model(), SIGNAL( columnsRemoved( const QModelIndex&, int, int ) ),
@@ -333,11 +336,11 @@ void LeveyJenningsDiagram::setModel( QAbstractItemModel* model )
     if( this->model() != 0 )
     {
         connect( this->model(), SIGNAL( dataChanged( const QModelIndex&, const QModelIndex& ) ),
-                                this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                this, SLOT( slotDataChanged( const QModelIndex&, const QModelIndex& ) ) );
         connect( this->model(), SIGNAL( rowsInserted( const QModelIndex&, int, int ) ),
-                                this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                this, SLOT( slotRowsInserted( const QModelIndex&, int, int ) ) );
         connect( this->model(), SIGNAL( rowsRemoved( const QModelIndex&, int, int ) ),
-                                this, SLOT( calculateMeanAndStandardDeviation() ) );
+                                this, SLOT( slotRowsRemoved( const QModelIndex&, int, int ) ) );
         connect( this->model(), SIGNAL( columnsInserted( const QModelIndex&, int, int ) ),
                                 this, SLOT( calculateMeanAndStandardDeviation() ) );
         connect( this->model(), SIGNAL( columnsRemoved( const QModelIndex&, int, int ) ),
@@ -351,38 +354,47 @@ void LeveyJenningsDiagram::setModel( QAbstractItemModel* model )
     }
 }
 
-// TODO: This is the 'easy' solution
-// evaluate whether this is enough or we need some better one or even boost here
+/**
+ * Reads all QC values and times again, as needed after the model has been
+ * reset or its columns have changed. Row insertions, removals and changes
+ * only update the statistics for the affected rows.
+ */
 void LeveyJenningsDiagram::calculateMeanAndStandardDeviation() const
 {
-    QVector< double > values;
-    // first fetch all values
-    const QAbstractItemModel& m = *model();
-    const int rowCount = m.rowCount( rootIndex() );
-
-    for( int row = 0; row < rowCount; ++row )
-    {
-        const QVariant var = m.data( m.index( row, 1, rootIndex() ) );
-        if( !var.isValid() )
-            continue;
-        const double value = var.toDouble();
-        if( ISNAN( value ) )
-            continue;
-        values << value;
-    }
+    const_cast< LeveyJenningsDiagram::Private* >( d )->resetStatistics();
+}
 
-    double sum = 0.0;
-    double sumSquares = 0.0;
-    KDAB_FOREACH( double value, values )
-    {
-        sum += value;
-        sumSquares += value * value;
-    }
+void LeveyJenningsDiagram::slotRowsInserted( const QModelIndex& parent, int first, int last )
+{
+    if( parent != rootIndex() )
+        return;
+    // the statistics don't know the rows before these, e.g. after the
+    // root index changed
+    if( first > d->values.size() )
+        d->resetStatistics();
+    else
+        d->insertRows( first, last );
+}
 
-    const int N = values.count();
+void LeveyJenningsDiagram::slotRowsRemoved( const QModelIndex& parent, int first, int last )
+{
+    if( parent != rootIndex() )
+        return;
+    // rows the statistics don't know about can't be taken out of them
+    if( last >= d->values.size() )
+        d->resetStatistics();
+    else
+        d->removeRows( first, last );
+}
 
-    d->calculatedMeanValue = sum / N;
-    d->calculatedStandardDeviation = sqrt( ( static_cast< double >( N ) * sumSquares - sum * sum ) / ( N * ( N - 1 ) ) );
+void LeveyJenningsDiagram::slotDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight )
+{
+    if( !topLeft.isValid() || topLeft.parent() != rootIndex() )
+        return;
+    // only the QC values and the times are part of the statistics
+    if( topLeft.column() > 3 || bottomRight.column() < 1 )
+        return;
+    d->updateRows( topLeft.row(), bottomRight.row() );
 }
 
 // calculates the largest QDate not greater than \a dt.
@@ -449,11 +461,9 @@ QPair< QDateTime, QDateTime > LeveyJenningsDiagram::timeRange() const
     if( d->timeRange != QPair< QDateTime, QDateTime >() )
         return d->timeRange;
 
-    const QAbstractItemModel& m = *model();
-    const int rowCount = m.rowCount( rootIndex() );
-
-    const QDateTime begin = m.data( m.index( 0, 3, rootIndex() ) ).toDateTime();
-    const QDateTime end = m.data( m.index( rowCount - 1, 3, rootIndex() ) ).toDateTime();
+    const QPair< QDateTime, QDateTime > dataRange = d->dataTimeRange();
+    const QDateTime begin = dataRange.first;
+    const QDateTime end = dataRange.second;
 
     if( begin.secsTo( end ) > 86400 )
     {
@@ -123,6 +123,12 @@ protected:
 
 protected Q_SLOTS:
     void calculateMeanAndStandardDeviation() const;
+
+private Q_SLOTS:
+    // keep the statistics up to date, looking at the affected rows only
+    void slotRowsInserted( const QModelIndex& parent, int first, int last );
+    void slotRowsRemoved( const QModelIndex& parent, int first, int last );
+    void slotDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight );
 }; // End of class KDChartLineDiagram
 
 }
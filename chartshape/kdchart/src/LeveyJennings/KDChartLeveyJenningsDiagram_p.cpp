@@ -25,8 +25,61 @@
 
 #include "KDChartLeveyJenningsDiagram_p.h"
 
+#include <limits>
+
 using namespace KDChart;
 
+RunningStatistics::RunningStatistics()
+    : count( 0 ),
+      meanValue( 0.0 ),
+      m2( 0.0 )
+{
+}
+
+void RunningStatistics::add( double value )
+{
+    ++count;
+    const double delta = value - meanValue;
+    meanValue += delta / count;
+    m2 += delta * ( value - meanValue );
+}
+
+void RunningStatistics::remove( double value )
+{
+    if( count <= 1 ) {
+        clear();
+        return;
+    }
+    --count;
+    const double delta = value - meanValue;
+    meanValue -= delta / count;
+    m2 -= delta * ( value - meanValue );
+    // rounding errors must not make the variance negative
+    if( m2 < 0.0 )
+        m2 = 0.0;
+}
+
+void RunningStatistics::clear()
+{
+    count = 0;
+    meanValue = 0.0;
+    m2 = 0.0;
+}
+
+double RunningStatistics::mean() const
+{
+    if( count < 1 )
+        return std::numeric_limits< double >::quiet_NaN();
+    return meanValue;
+}
+
+double RunningStatistics::standardDeviation() const
+{
+    if( count < 2 )
+        return std::numeric_limits< double >::quiet_NaN();
+    return std::sqrt( m2 / ( count - 1 ) );
+}
+
 LeveyJenningsDiagram::Private::Private( const Private& rhs )
     : LineDiagram::Private( rhs ),
       lotChangedPosition( rhs.lotChangedPosition ),
@@ -37,7 +90,15 @@ LeveyJenningsDiagram::Private::Private( const Private& rhs )
       scanLinePen( rhs.scanLinePen ),
       icons( rhs.icons ),
       expectedMeanValue( rhs.expectedMeanValue ),
-      expectedStandardDeviation( rhs.expectedStandardDeviation )
+      expectedStandardDeviation( rhs.expectedStandardDeviation ),
+      calculatedMeanValue( rhs.calculatedMeanValue ),
+      calculatedStandardDeviation( rhs.calculatedStandardDeviation ),
+      values( rhs.values ),
+      times( rhs.times ),
+      statistics( rhs.statistics ),
+      minTime( rhs.minTime ),
+      maxTime( rhs.maxTime ),
+      timeBoundsDirty( rhs.timeBoundsDirty )
 {
 }
 
@@ -50,3 +111,115 @@ void LeveyJenningsDiagram::Private::setYAxisRange() const
     plane->setVerticalRange( QPair< qreal, qreal >( expectedMeanValue - 4 * expectedStandardDeviation, 
                                                     expectedMeanValue + 4 * expectedStandardDeviation ) );
 }
+
+void LeveyJenningsDiagram::Private::readRow( int row, double* value, QDateTime* time ) const
+{
+    const QAbstractItemModel& m = *diagram->model();
+    const QVariant var = m.data( m.index( row, 1, diagram->rootIndex() ) );
+    *value = var.isValid() ? var.toDouble() : std::numeric_limits< double >::quiet_NaN();
+    *time = m.data( m.index( row, 3, diagram->rootIndex() ) ).toDateTime();
+}
+
+void LeveyJenningsDiagram::Private::addRow( int row )
+{
+    if( !ISNAN( values[ row ] ) )
+        statistics.add( values[ row ] );
+
+    const QDateTime& time = times[ row ];
+    if( time.isValid() && !timeBoundsDirty ) {
+        if( !minTime.isValid() || time < minTime )
+            minTime = time;
+        if( !maxTime.isValid() || time > maxTime )
+            maxTime = time;
+    }
+}
+
+void LeveyJenningsDiagram::Private::removeRow( int row )
+{
+    if( !ISNAN( values[ row ] ) )
+        statistics.remove( values[ row ] );
+
+    // the bounds can only be found again by looking at all times
+    const QDateTime& time = times[ row ];
+    if( time.isValid() && ( time == minTime || time == maxTime ) )
+        timeBoundsDirty = true;
+}
+
+void LeveyJenningsDiagram::Private::updateCalculatedValues()
+{
+    calculatedMeanValue = statistics.mean();
+    calculatedStandardDeviation = statistics.standardDeviation();
+}
+
+void LeveyJenningsDiagram::Private::resetStatistics()
+{
+    const int rowCount = diagram->model() ? diagram->model()->rowCount( diagram->rootIndex() ) : 0;
+    values.resize( rowCount );
+    times.resize( rowCount );
+    statistics.clear();
+    minTime = QDateTime();
+    maxTime = QDateTime();
+    timeBoundsDirty = false;
+    for( int row = 0; row < rowCount; ++row ) {
+        readRow( row, &values[ row ], &times[ row ] );
+        addRow( row );
+    }
+    updateCalculatedValues();
+}
+
+void LeveyJenningsDiagram::Private::insertRows( int first, int last )
+{
+    const int count = last - first + 1;
+    values.insert( first, count, 0.0 );
+    times.insert( first, count, QDateTime() );
+    for( int row = first; row <= last; ++row ) {
+        readRow( row, &values[ row ], &times[ row ] );
+        addRow( row );
+    }
+    updateCalculatedValues();
+}
+
+void LeveyJenningsDiagram::Private::removeRows( int first, int last )
+{
+    for( int row = first; row <= last; ++row )
+        removeRow( row );
+    values.remove( first, last - first + 1 );
+    times.remove( first, last - first + 1 );
+    updateCalculatedValues();
+}
+
+void LeveyJenningsDiagram::Private::updateRows( int first, int last )
+{
+    // rows the model didn't tell us about are read on the next reset
+    last = qMin( last, values.size() - 1 );
+    for( int row = first; row <= last; ++row ) {
+        const QDateTime oldTime = times[ row ];
+        const bool wasDirty = timeBoundsDirty;
+        removeRow( row );
+        readRow( row, &values[ row ], &times[ row ] );
+        // usually only the value changes, which keeps the bounds valid
+        if( times[ row ] == oldTime )
+            timeBoundsDirty = wasDirty;
+        addRow( row );
+    }
+    updateCalculatedValues();
+}
+
+QPair< QDateTime, QDateTime > LeveyJenningsDiagram::Private::dataTimeRange() const
+{
+    if( timeBoundsDirty ) {
+        minTime = QDateTime();
+        maxTime = QDateTime();
+        KDAB_FOREACH( const QDateTime& time, times )
+        {
+            if( !time.isValid() )
+                continue;
+            if( !minTime.isValid() || time < minTime )
+                minTime = time;
+            if( !maxTime.isValid() || time > maxTime )
+                maxTime = time;
+        }
+        timeBoundsDirty = false;
+    }
+    return QPair< QDateTime, QDateTime >( minTime, maxTime );
+}
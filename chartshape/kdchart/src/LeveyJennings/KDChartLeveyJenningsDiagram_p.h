@@ -35,6 +35,7 @@
 //
 
 #include <QDateTime>
+#include <QVector>
 
 #include "KDChartThreeDLineAttributes.h"
 #include "KDChartLineDiagram_p.h"
@@ -47,6 +48,31 @@ namespace KDChart {
 
     class PaintContext;
 
+/**
+ * \internal
+ * Mean and variance of some values, updated one value at a time with
+ * Welford's method.
+ */
+    class RunningStatistics
+    {
+    public:
+        RunningStatistics();
+
+        void add( double value );
+        void remove( double value );
+        void clear();
+
+        // NaN for less than one, respectively two, values
+        double mean() const;
+        double standardDeviation() const;
+
+    private:
+        int count;
+        double meanValue;
+        // sum of the squared differences from the mean
+        double m2;
+    };
+
 /**
  * \internal
  */
@@ -60,6 +86,16 @@ namespace KDChart {
 
         void setYAxisRange() const;
 
+        // read all rows of the model again
+        void resetStatistics();
+        // update the statistics after the rows [first, last] have been
+        // inserted, removed or changed
+        void insertRows( int first, int last );
+        void removeRows( int first, int last );
+        void updateRows( int first, int last );
+        // the time range spanned by the data
+        QPair< QDateTime, QDateTime > dataTimeRange() const;
+
         Qt::Alignment lotChangedPosition;
         Qt::Alignment fluidicsPackChangedPosition;
         Qt::Alignment sensorChangedPosition;
@@ -79,6 +115,23 @@ namespace KDChart {
 
         mutable float calculatedMeanValue;
         mutable float calculatedStandardDeviation;
+
+        // the QC value and the time of each row, NaN respectively invalid
+        // if missing, so that changed and removed rows can be taken out
+        // of the statistics again
+        QVector< double > values;
+        QVector< QDateTime > times;
+        RunningStatistics statistics;
+        // earliest and latest time, recomputed from times if dirty
+        mutable QDateTime minTime;
+        mutable QDateTime maxTime;
+        mutable bool timeBoundsDirty;
+
+    private:
+        void readRow( int row, double* value, QDateTime* time ) const;
+        void addRow( int row );
+        void removeRow( int row );
+        void updateCalculatedValues();
     };
 
     KDCHART_IMPL_DERIVED_DIAGRAM( LeveyJenningsDiagram, LineDiagram, LeveyJenningsCoordinatePlane )
@@ -0,0 +1,128 @@
+/****************************************************************************
+** Copyright (C) 2001-2010 Klaralvdalens Datakonsult AB.  All rights reserved.
+**
+** This file is part of the KD Chart library.
+**
+** Licensees holding valid commercial KD Chart licenses may use this file in
+** accordance with the KD Chart Commercial License Agreement provided with
+** the Software.
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 and version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE.GPL included.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Contact info@kdab.com if any conditions of this licensing are not
+** clear to you.
+**
+**********************************************************************/
+
+
+#include "KDChartMarkerSpriteCache.h"
+
+#include <QHash>
+
+MarkerSpriteCache::Key::Key()
+    : style( 0 )
+    , threeD( false )
+    , scaleX( 1.0 )
+    , scaleY( 1.0 )
+    , penColor( 0 )
+    , penWidth( 0.0 )
+    , brushColor( 0 )
+    , brushStyle( 0 )
+{
+}
+
+bool MarkerSpriteCache::Key::operator==( const Key& other ) const
+{
+    return style == other.style
+        && threeD == other.threeD
+        && size == other.size
+        && scaleX == other.scaleX
+        && scaleY == other.scaleY
+        && penColor == other.penColor
+        && penWidth == other.penWidth
+        && brushColor == other.brushColor
+        && brushStyle == other.brushStyle;
+}
+
+static uint hashReal( qreal value )
+{
+    // rounded, so that equal values are never hashed differently
+    return qHash( qRound64( value * 1024.0 ) );
+}
+
+uint qHash( const MarkerSpriteCache::Key& key )
+{
+    uint hash = qHash( key.style ) ^ ( key.threeD ? 0x80000000 : 0 );
+    hash = 31 * hash + hashReal( key.size.width() );
+    hash = 31 * hash + hashReal( key.size.height() );
+    hash = 31 * hash + hashReal( key.scaleX );
+    hash = 31 * hash + hashReal( key.scaleY );
+    hash = 31 * hash + key.penColor;
+    hash = 31 * hash + hashReal( key.penWidth );
+    hash = 31 * hash + key.brushColor;
+    return 31 * hash + qHash( key.brushStyle );
+}
+
+MarkerSpriteCache::MarkerSpriteCache()
+    : m_sprites( 1024 )
+    , m_hits( 0 )
+    , m_misses( 0 )
+{
+}
+
+void MarkerSpriteCache::setMaxCost( int kiloBytes )
+{
+    m_sprites.setMaxCost( qMax( 0, kiloBytes ) );
+}
+
+int MarkerSpriteCache::maxCost() const
+{
+    return m_sprites.maxCost();
+}
+
+const QImage* MarkerSpriteCache::sprite( const Key& key )
+{
+    const QImage* const image = m_sprites.object( key );
+    if ( image )
+        ++m_hits;
+    else
+        ++m_misses;
+    return image;
+}
+
+const QImage* MarkerSpriteCache::insert( const Key& key, const QImage& sprite )
+{
+    // the cost is counted in kilobytes, rounded up
+    const int cost = ( sprite.bytesPerLine() * sprite.height() + 1023 ) / 1024;
+    QImage* const image = new QImage( sprite );
+    // QCache deletes the image right away if it doesn't fit
+    return m_sprites.insert( key, image, cost ) ? image : 0;
+}
+
+void MarkerSpriteCache::clear()
+{
+    m_sprites.clear();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+int MarkerSpriteCache::hits() const
+{
+    return m_hits;
+}
+
+int MarkerSpriteCache::misses() const
+{
+    return m_misses;
+}
+
+int MarkerSpriteCache::count() const
+{
+    return m_sprites.count();
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+** Copyright (C) 2001-2010 Klaralvdalens Datakonsult AB.  All rights reserved.
+**
+** This file is part of the KD Chart library.
+**
+** Licensees holding valid commercial KD Chart licenses may use this file in
+** accordance with the KD Chart Commercial License Agreement provided with
+** the Software.
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 and version 3 as published by the
+** Free Software Foundation and appearing in the file LICENSE.GPL included.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Contact info@kdab.com if any conditions of this licensing are not
+** clear to you.
+**
+**********************************************************************/
+
+
+#ifndef KDCHARTMARKERSPRITECACHE_H
+#define KDCHARTMARKERSPRITECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QSizeF>
+#include <QRgb>
+
+/**
+    @brief MarkerSpriteCache is an internal KDChart class holding prerendered
+    data point markers.
+
+    Painting a marker from a sprite is a single image blit, while painting
+    it as a vector shape means stroking and filling a path every time.
+    Each sprite is rendered for one device scale, so it is only valid for
+    raster output. The cache is bounded by the memory the sprites take.
+*/
+class MarkerSpriteCache
+{
+public:
+    /** Everything a rendered marker depends on. */
+    class Key {
+    public:
+        Key();
+
+        bool operator==( const Key& other ) const;
+
+        int style;
+        bool threeD;
+        QSizeF size;
+        qreal scaleX;
+        qreal scaleY;
+        QRgb penColor;
+        qreal penWidth;
+        QRgb brushColor;
+        int brushStyle;
+    };
+
+    MarkerSpriteCache();
+
+    /** Sets the maximum memory the sprites may take, in kilobytes.
+        0 disables the cache. */
+    void setMaxCost( int kiloBytes );
+    int maxCost() const;
+
+    /** Returns the sprite for \a key, or 0 if none has been rendered yet. */
+    const QImage* sprite( const Key& key );
+    /** Stores \a sprite, rendered for \a key, and returns the stored copy,
+        or 0 if it is too large for the cache. */
+    const QImage* insert( const Key& key, const QImage& sprite );
+    void clear();
+
+    /** The number of sprite() calls that found a sprite. */
+    int hits() const;
+    /** The number of sprite() calls that didn't find a sprite. */
+    int misses() const;
+    /** The number of sprites cached right now. */
+    int count() const;
+
+private:
+    QCache<Key, QImage> m_sprites;
+    int m_hits;
+    int m_misses;
+};
+
+uint qHash( const MarkerSpriteCache::Key& key );
+
+#endif
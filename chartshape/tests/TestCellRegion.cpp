@@ -29,6 +29,7 @@
 
 // KChart
 #include "CellRegion.h"
+#include "DataSet.h"
 
 TestCellRegion::TestCellRegion()
     : QObject(0)
@@ -95,6 +96,73 @@ void TestCellRegion::testListOfRegions()
     }
 }
 
+void TestCellRegion::testFromStringMultiLetterColumns()
+{
+    CellRegion region(&m_source, QString("$Table1.$Z$1:$AB$1;$Table1.$AAA$2"));
+    QCOMPARE(region.table(), m_source.get("Table1"));
+    QCOMPARE(region.rectCount(), 2);
+    QCOMPARE(region.rects()[0], QRect(QPoint(26, 1), QPoint(28, 1)));
+    QCOMPARE(region.rects()[1], QRect(703, 2, 1, 1));
+    QCOMPARE(region.toString(), QString("$Table1.$Z$1:$AB$1;$Table1.$AAA$2"));
+}
+
+void TestCellRegion::testFromStringQuotedSeparators()
+{
+    m_source.rename("Table1", "table one;1.0");
+    CellRegion region(&m_source, QString("$'table one;1.0'.$B$3:$K$13 $'table one;1.0'.$B$15"));
+    QCOMPARE(region.table(), m_source.get("table one;1.0"));
+    QCOMPARE(region.rectCount(), 2);
+    QCOMPARE(region.rects()[0], QRect(2, 3, 10, 11));
+    QCOMPARE(region.rects()[1], QRect(2, 15, 1, 1));
+}
+
+void TestCellRegion::testColumnNames()
+{
+    QCOMPARE(CellRegion::rangeIntToString(1), QString("A"));
+    QCOMPARE(CellRegion::rangeIntToString(26), QString("Z"));
+    QCOMPARE(CellRegion::rangeIntToString(27), QString("AA"));
+    QCOMPARE(CellRegion::rangeIntToString(703), QString("AAA"));
+    QCOMPARE(CellRegion::rangeStringToInt("AB"), 28);
+    QCOMPARE(CellRegion::rangeStringToInt("a"), -1);
+
+    for (int column = 1; column <= 1000; column++) {
+        const QString name = CellRegion::rangeIntToString(column);
+        QCOMPARE(CellRegion::rangeStringToInt(name), column);
+        // The parser has to agree with the public conversion
+        CellRegion region(&m_source, QString("$Table1.$%1$1").arg(name));
+        QCOMPARE(region.rects()[0].left(), column);
+    }
+}
+
+void TestCellRegion::benchmarkFromString()
+{
+    QStringList ranges;
+    for (int i = 0; i < 10000; i++) {
+        const QString column = CellRegion(m_source.get("Table1"), QPoint(i % 1000 + 1, 1)).toString().section('$', 2, 2);
+        ranges.append(QString("$Table1.$%1$1:$%1$100;$Table1.$%1$200:$%1$300").arg(column));
+    }
+
+    QBENCHMARK {
+        foreach (const QString &range, ranges)
+            CellRegion(&m_source, range);
+    }
+}
+
+void TestCellRegion::benchmarkToString()
+{
+    QList<CellRegion> regions;
+    for (int i = 0; i < 10000; i++) {
+        CellRegion region(m_source.get("Table1"), QRect(i % 1000 + 1, 1, 1, 100));
+        region.add(QRect(i % 1000 + 1, 200, 1, 101));
+        regions.append(region);
+    }
+
+    QBENCHMARK {
+        foreach (const CellRegion &region, regions)
+            region.toString();
+    }
+}
+
 void TestCellRegion::testToStringMultipleTables()
 {
     QEXPECT_FAIL("", "Functionality is not yet supported, so its expected to fail", Continue);
@@ -131,4 +199,118 @@ void TestCellRegion::testFromStringWithSpecialCharactersMultipleTables()
     QCOMPARE(region.table(), m_source.get("table-one"));
 }
 
+void TestCellRegion::testPointAtIndex()
+{
+    Table *t1 = m_source.get("Table1");
+    CellRegion region(t1, QRect(2, 3, 1, 4));
+    region.add(QRect(5, 1, 3, 1));
+    region.add(QPoint(9, 9));
+
+    QCOMPARE(region.pointAtIndex(0), QPoint(2, 3));
+    QCOMPARE(region.pointAtIndex(3), QPoint(2, 6));
+    QCOMPARE(region.pointAtIndex(4), QPoint(5, 1));
+    QCOMPARE(region.pointAtIndex(6), QPoint(7, 1));
+    QCOMPARE(region.pointAtIndex(7), QPoint(9, 9));
+    QCOMPARE(region.pointAtIndex(8), QPoint(-1, -1));
+    QCOMPARE(region.pointAtIndex(-1), QPoint(-1, -1));
+    QVERIFY(region.hasPointAtIndex(7));
+    QVERIFY(!region.hasPointAtIndex(8));
+}
+
+void TestCellRegion::testIndexAtPoint()
+{
+    Table *t1 = m_source.get("Table1");
+    CellRegion region(t1, QRect(2, 3, 1, 4));
+    region.add(QRect(5, 1, 3, 1));
+    region.add(QPoint(9, 9));
+
+    QCOMPARE(region.indexAtPoint(QPoint(2, 3)), 0);
+    QCOMPARE(region.indexAtPoint(QPoint(2, 6)), 3);
+    QCOMPARE(region.indexAtPoint(QPoint(6, 1)), 5);
+    QCOMPARE(region.indexAtPoint(QPoint(9, 9)), 7);
+    QCOMPARE(region.indexAtPoint(QPoint(1, 1)), -1);
+}
+
+void TestCellRegion::testIterator()
+{
+    Table *t1 = m_source.get("Table1");
+    CellRegion region(t1, QRect(2, 3, 1, 4));
+    region.add(QRect());
+    region.add(QRect(5, 1, 3, 1));
+    region.add(QPoint(9, 9));
+
+    int i = 0;
+    CellRegion::const_iterator end = region.end();
+    for (CellRegion::const_iterator it = region.begin(); it != end; ++it, ++i) {
+        QCOMPARE(it.index(), i);
+        QCOMPARE(*it, region.pointAtIndex(i));
+    }
+    QCOMPARE(i, 8);
+
+    CellRegion empty;
+    QVERIFY(empty.begin() == empty.end());
+}
+
+void TestCellRegion::testImplicitSharing()
+{
+    CellRegion copy(m_region1);
+    QCOMPARE(copy, m_region1);
+
+    // Modifying the copy must not affect the original
+    copy.add(QRect(20, 1, 1, 5));
+    QCOMPARE(copy.rectCount(), 2);
+    QCOMPARE(copy.pointAtIndex(11), QPoint(20, 2));
+    QCOMPARE(m_region1.rectCount(), 1);
+    QCOMPARE(m_region1.toString(), QString("$Table1.$B$3:$K$13"));
+    QVERIFY(!m_region1.hasPointAtIndex(10));
+
+    // Neither must modifying the original affect the copy
+    CellRegion other = copy;
+    copy = m_region1;
+    copy.add(QPoint(1, 1));
+    QCOMPARE(other.rectCount(), 2);
+    QCOMPARE(m_region1.rectCount(), 1);
+    QCOMPARE(copy.rectCount(), 2);
+    QCOMPARE(copy.table(), m_region1.table());
+}
+
+void TestCellRegion::testRegionIndex()
+{
+    Table *t1 = m_source.get("Table1");
+    Table *t2 = m_source.get("Table2");
+
+    DataSet set1(0);
+    DataSet set2(1);
+    DataSet *dataSet1 = &set1;
+    DataSet *dataSet2 = &set2;
+
+    CellRegionIndex index;
+    // 100 columns of 50 cells each, one data set per column
+    for (int i = 0; i < 100; i++)
+        index.setRegion(i == 42 ? dataSet2 : dataSet1, i, CellRegion(t1, QRect(i + 1, 1, 1, 50)));
+    index.setRegion(dataSet1, 100, CellRegion(t2, QRect(43, 1, 1, 50)));
+
+    QList<CellRegionIndex::Entry> hits = index.intersecting(CellRegion(t1, QPoint(43, 10)));
+    QCOMPARE(hits.count(), 1);
+    QCOMPARE(hits[0], CellRegionIndex::Entry(dataSet2, 42));
+
+    hits = index.intersecting(CellRegion(t1, QRect(42, 50, 3, 1)));
+    QCOMPARE(hits.count(), 3);
+    QVERIFY(hits.contains(CellRegionIndex::Entry(dataSet1, 41)));
+    QVERIFY(hits.contains(CellRegionIndex::Entry(dataSet2, 42)));
+    QVERIFY(hits.contains(CellRegionIndex::Entry(dataSet1, 43)));
+
+    QVERIFY(index.intersecting(CellRegion(t1, QPoint(43, 51))).isEmpty());
+
+    // Moving a region must be reflected by the next query
+    index.setRegion(dataSet2, 42, CellRegion(t1, QRect(200, 1, 1, 50)));
+    QVERIFY(index.intersecting(CellRegion(t1, QPoint(43, 10))).isEmpty());
+    QCOMPARE(index.intersecting(CellRegion(t1, QPoint(200, 10))).count(), 1);
+
+    index.remove(dataSet1);
+    QVERIFY(index.intersecting(CellRegion(t1, QPoint(1, 1))).isEmpty());
+    QVERIFY(index.intersecting(CellRegion(t2, QPoint(43, 1))).isEmpty());
+    QCOMPARE(index.intersecting(CellRegion(t1, QPoint(200, 10))).count(), 1);
+}
+
 QTEST_MAIN(TestCellRegion)
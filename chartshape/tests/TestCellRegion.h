@@ -30,6 +30,7 @@
 // KChart
 #include "../CellRegion.h"
 #include "../TableSource.h"
+#include "../CellRegionIndex.h"
 
 class TestCellRegion : public QObject
 {
@@ -50,6 +51,16 @@ private slots:
     void testFromStringWithSpecialCharactersMultipleTables();
     void testTableNameChangeMultipleTables();
     void testListOfRegions();
+    void testFromStringMultiLetterColumns();
+    void testFromStringQuotedSeparators();
+    void testColumnNames();
+    void benchmarkFromString();
+    void benchmarkToString();
+    void testPointAtIndex();
+    void testIndexAtPoint();
+    void testIterator();
+    void testImplicitSharing();
+    void testRegionIndex();
 
 private:
     TableSource m_source;
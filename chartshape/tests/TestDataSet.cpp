@@ -33,6 +33,11 @@
 #include "DataSet.h"
 #include "CellRegion.h"
 
+// KDChart
+#include <KDChartDataValueAttributes>
+#include <KDChartMarkerAttributes>
+#include <KDChartTextAttributes>
+
 
 namespace QTest {
     template<>
@@ -190,4 +195,117 @@ void TestDataSet::testFooDataMultipleTables()
     QCOMPARE(dataSet.customData(3), QVariant(12));
 }
 
+void TestDataSet::testFetchData()
+{
+    DataSet dataSet(0);
+
+    dataSet.setCategoryDataRegion(CellRegion(m_table1, QRect(2, 1, 4, 1)));
+    dataSet.setXDataRegion(CellRegion(m_table1, QRect(2, 2, 4, 1)));
+    dataSet.setYDataRegion(CellRegion(m_table1, QRect(2, 3, 4, 1)));
+
+    double values[5];
+    quint8 valid[5];
+
+    // Beyond the end of the region
+    QCOMPARE(dataSet.fetchYData(1, 5, values, valid), 3);
+    QCOMPARE(values[0], 2.9);
+    QCOMPARE(values[1], 3.7);
+    QCOMPARE(values[2], 5.5);
+    QCOMPARE(valid[2], quint8(1));
+    QCOMPARE(valid[3], quint8(0));
+    QCOMPARE(valid[4], quint8(0));
+
+    QCOMPARE(dataSet.fetchXData(0, 4, values), 4);
+    QCOMPARE(values[0], 7.2);
+    QCOMPARE(values[3], 1.5);
+
+    // No region at all, x data falls back to the index
+    QCOMPARE(dataSet.fetchCustomData(0, 2, values, valid), 0);
+    QCOMPARE(valid[0], quint8(0));
+    dataSet.setXDataRegion(CellRegion());
+    QCOMPARE(dataSet.fetchXData(0, 2, values), 2);
+    QCOMPARE(values[0], 1.0);
+    QCOMPARE(values[1], 2.0);
+
+    QVariant categories[5];
+    dataSet.fetchCategoryData(2, 3, categories);
+    QCOMPARE(categories[0], QVariant("Column 3"));
+    QCOMPARE(categories[1], QVariant("Column 4"));
+    QCOMPARE(categories[2], QVariant(QString::number(5)));
+}
+
+void TestDataSet::testStreaming()
+{
+    DataSet dataSet(0);
+    dataSet.setYDataRegion(CellRegion(m_table1, QRect(2, 3, 4, 1)));
+    dataSet.setStreamingCapacity(3);
+
+    // Streamed data replaces the data in the regions
+    QVERIFY(dataSet.isStreaming());
+    QCOMPARE(dataSet.streamingCapacity(), 3);
+    QCOMPARE(dataSet.size(), 1);
+
+    const double first[] = { 1.0, 2.0 };
+    dataSet.appendData(first, 2);
+    QCOMPARE(dataSet.size(), 2);
+    QCOMPARE(dataSet.yData(0), QVariant(1.0));
+    QCOMPARE(dataSet.yData(1), QVariant(2.0));
+    QCOMPARE(dataSet.xData(1), QVariant(2.0));
+
+    // Wraps around, dropping the oldest values
+    const double second[] = { 3.0, 4.0, 5.0 };
+    dataSet.appendData(second, 3);
+    QCOMPARE(dataSet.size(), 3);
+    QCOMPARE(dataSet.yData(0), QVariant(3.0));
+    QCOMPARE(dataSet.yData(2), QVariant(5.0));
+
+    // Data points are numbered by the number of points streamed so far
+    QCOMPARE(dataSet.xData(0), QVariant(3.0));
+    QCOMPARE(dataSet.categoryData(2), QVariant(QString::number(5)));
+
+    double values[3];
+    QCOMPARE(dataSet.fetchYData(0, 3, values), 3);
+    QCOMPARE(values[0], 3.0);
+    QCOMPARE(values[1], 4.0);
+    QCOMPARE(values[2], 5.0);
+
+    const double xValues[] = { 10.0, 20.0, 30.0, 40.0 };
+    const double yValues[] = { 6.0, 7.0, 8.0, 9.0 };
+    dataSet.appendData(xValues, yValues, 4);
+    QCOMPARE(dataSet.size(), 3);
+    QCOMPARE(dataSet.xData(0), QVariant(20.0));
+    QCOMPARE(dataSet.yData(2), QVariant(9.0));
+
+    // Leaving streaming mode brings the regions back
+    dataSet.setStreamingCapacity(0);
+    QVERIFY(!dataSet.isStreaming());
+    QCOMPARE(dataSet.size(), 4);
+    QCOMPARE(dataSet.yData(0), QVariant(8.4));
+}
+
+void TestDataSet::testDataValueAttributes()
+{
+    DataSet dataSet(0);
+    dataSet.setChartType(BarChartType);
+    dataSet.setBrush(QBrush(Qt::red));
+    dataSet.setPen(2, QPen(Qt::blue));
+
+    QCOMPARE(dataSet.dataValueAttributes(0).markerAttributes().markerColor(), QColor(Qt::red));
+    QCOMPARE(dataSet.dataValueAttributes(1).markerAttributes().markerColor(), QColor(Qt::red));
+    QCOMPARE(dataSet.dataValueAttributes(2).markerAttributes().pen(), QPen(Qt::blue));
+
+    // Cached attributes have to follow changes of the data set
+    dataSet.setBrush(QBrush(Qt::green));
+    QCOMPARE(dataSet.dataValueAttributes(0).markerAttributes().markerColor(), QColor(Qt::green));
+    QCOMPARE(dataSet.dataValueAttributes(2).markerAttributes().markerColor(), QColor(Qt::green));
+    dataSet.setPen(2, QPen(Qt::yellow));
+    QCOMPARE(dataSet.dataValueAttributes(2).markerAttributes().pen(), QPen(Qt::yellow));
+
+    dataSet.setValueLabelType(DataSet::RealValueLabel, 3);
+    QVERIFY(dataSet.dataValueAttributes(3).textAttributes().isVisible());
+    QVERIFY(!dataSet.dataValueAttributes(0).textAttributes().isVisible());
+    QCOMPARE(dataSet.valueLabelType(3), DataSet::RealValueLabel);
+    QCOMPARE(dataSet.valueLabelType(0), DataSet::NoValueLabel);
+}
+
 QTEST_MAIN(TestDataSet)
@@ -42,6 +42,9 @@ private slots:
     // Tests DataSet::*Data() methods
     void testFooData();
     void testFooDataMultipleTables();
+    void testFetchData();
+    void testDataValueAttributes();
+    void testStreaming();
 
 private:
     // m_source must be initialized before m_proxyModel
@@ -298,4 +298,81 @@ void TestKDChartModel::testDataChangesWithTwoDimensions()
     QCOMPARE(m_testModel->m_lastDataChange.bottomRight, m_model->index(9, 3));
 }
 
+void TestKDChartModel::testValueCache()
+{
+    DataSet dataSet1(0);
+    dataSet1.setYDataRegion(CellRegion(m_table, QRect(2, 2, 10, 1)));
+    m_model->addDataSet(&dataSet1);
+
+    // The first request fills the cache for the whole data set
+    QCOMPARE(m_model->data(m_model->index(0, 0)), QVariant(7.2));
+    QCOMPARE(m_model->cacheMisses(), 1);
+    QCOMPARE(m_model->data(m_model->index(1, 0)), QVariant(1.8));
+    QCOMPARE(m_model->data(m_model->index(9, 0)), QVariant(5.3));
+    QCOMPARE(m_model->cacheHits(), 2);
+    QCOMPARE(m_model->cacheMisses(), 1);
+
+    // Changed values must not be served from the cache
+    m_itemModel.setData(m_itemModel.index(1, 2), 4.2);
+    dataSet1.yDataChanged(QRect(3, 2, 1, 1));
+    QCOMPARE(m_model->data(m_model->index(1, 0)), QVariant(4.2));
+    QCOMPARE(m_model->cacheMisses(), 2);
+    // Only the changed data point was invalidated
+    QCOMPARE(m_model->data(m_model->index(2, 0)), QVariant(9.4));
+    QCOMPARE(m_model->cacheMisses(), 2);
+    m_itemModel.setData(m_itemModel.index(1, 2), 1.8);
+
+    // Cells are returned as they are, not converted to numbers
+    m_itemModel.setData(m_itemModel.index(1, 3), 9);
+    m_itemModel.setData(m_itemModel.index(1, 4), "n/a");
+    dataSet1.yDataChanged(QRect(4, 2, 2, 1));
+    QCOMPARE(m_model->data(m_model->index(2, 0)), QVariant(9));
+    QCOMPARE(m_model->data(m_model->index(3, 0)), QVariant("n/a"));
+    m_itemModel.setData(m_itemModel.index(1, 3), 9.4);
+    m_itemModel.setData(m_itemModel.index(1, 4), 1.5);
+    dataSet1.yDataChanged(QRect(4, 2, 2, 1));
+
+    dataSet1.setYDataRegion(CellRegion(m_table, QRect(2, 3, 10, 1)));
+    QCOMPARE(m_model->data(m_model->index(0, 0)), QVariant(8.2));
+    QCOMPARE(m_model->cacheMisses(), 4);
+
+    m_model->resetCacheStatistics();
+    QCOMPARE(m_model->cacheHits(), 0);
+    QCOMPARE(m_model->cacheMisses(), 0);
+}
+
+void TestKDChartModel::testBatchedUpdates()
+{
+    DataSet dataSet1(0);
+    DataSet dataSet2(1);
+    dataSet1.setYDataRegion(CellRegion(m_table, QRect(2, 2, 10, 1)));
+    dataSet2.setYDataRegion(CellRegion(m_table, QRect(2, 3, 10, 1)));
+    m_model->addDataSet(&dataSet1);
+    m_model->addDataSet(&dataSet2);
+
+    m_testModel->m_lastDataChange.valid = false;
+    m_testModel->m_lastHeaderDataChange.valid = false;
+
+    m_model->beginUpdate();
+    m_model->dataSetChanged(&dataSet2, KDChartModel::YDataRole, 2);
+    m_model->dataSetChanged(&dataSet2, KDChartModel::YDataRole, 5, 7);
+    m_model->dataSetChanged(&dataSet2, KDChartModel::YDataRole, 4);
+    m_model->dataSetChanged(&dataSet2);
+    m_model->dataSetChanged(&dataSet2);
+    QVERIFY(m_model->isUpdating());
+    QVERIFY(!m_testModel->m_lastDataChange.valid);
+    QVERIFY(!m_testModel->m_lastHeaderDataChange.valid);
+    m_model->endUpdate();
+
+    QVERIFY(!m_model->isUpdating());
+    QVERIFY(m_testModel->m_lastDataChange.valid);
+    QCOMPARE(m_testModel->m_lastDataChange.topLeft, m_model->index(2, 1));
+    QCOMPARE(m_testModel->m_lastDataChange.bottomRight, m_model->index(7, 1));
+    QVERIFY(m_testModel->m_lastHeaderDataChange.valid);
+    QCOMPARE(m_testModel->m_lastHeaderDataChange.first, 1);
+    QCOMPARE(m_testModel->m_lastHeaderDataChange.last, 1);
+    // Five changes, two signals
+    QCOMPARE(m_model->suppressedSignalCount(), 3);
+}
+
 QTEST_MAIN(TestKDChartModel)
@@ -45,6 +45,8 @@ private slots:
     void testData();
     void testDataChanges();
     void testDataChangesWithTwoDimensions();
+    void testValueCache();
+    void testBatchedUpdates();
 
 private:
     KDChartModel *m_model;
@@ -0,0 +1,201 @@
+/* This file is part of the KDE project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Own
+#include "TestModelDataCache.h"
+
+// Qt
+#include <QtTest>
+#include <QVector>
+
+// KDChart
+#include "KDChartModelDataCache_p.h"
+
+using namespace KDChart;
+using KDChart::ModelDataCachePrivate::CellStorage;
+
+static const int BenchmarkRows = 100000;
+static const int BenchmarkColumns = 10;
+static const int BenchmarkAppendedRows = 1000;
+
+/**
+ * The row-major layout of nested vectors that ModelDataCache used before
+ */
+class NestedStorage
+{
+public:
+    void reset(int rows, int columns)
+    {
+        m_data.fill(QVector<double>(columns), rows);
+        m_valid.fill(QVector<bool>(columns, false), rows);
+    }
+    bool isValid(int row, int column) const { return m_valid.at(row).at(column); }
+    double value(int row, int column) const { return m_data.at(row).at(column); }
+    void setValue(int row, int column, double value)
+    {
+        m_data[row][column] = value;
+        m_valid[row][column] = true;
+    }
+    void insertRows(int start, int count)
+    {
+        const int columns = m_data.isEmpty() ? 0 : m_data.first().count();
+        m_data.insert(start, count, QVector<double>(columns));
+        m_valid.insert(start, count, QVector<bool>(columns, false));
+    }
+
+private:
+    QVector< QVector<double> > m_data;
+    QVector< QVector<bool> > m_valid;
+};
+
+/**
+ * Fills all cells, reads them column by column as the diagrams do and
+ * appends some rows, as a streaming data source does.
+ */
+template<class Storage>
+static double exerciseStorage(Storage &storage)
+{
+    storage.reset(BenchmarkRows, BenchmarkColumns);
+    for (int column = 0; column < BenchmarkColumns; column++)
+        for (int row = 0; row < BenchmarkRows; row++)
+            storage.setValue(row, column, row + column);
+
+    double sum = 0.0;
+    for (int column = 0; column < BenchmarkColumns; column++)
+        for (int row = 0; row < BenchmarkRows; row++)
+            if (storage.isValid(row, column))
+                sum += storage.value(row, column);
+
+    for (int i = 0; i < BenchmarkAppendedRows; i++)
+        storage.insertRows(BenchmarkRows + i, 1);
+
+    return sum;
+}
+
+TestModelDataCache::TestModelDataCache()
+    : QObject(0)
+{
+}
+
+void TestModelDataCache::init()
+{
+    m_model.clear();
+    m_model.setRowCount(4);
+    m_model.setColumnCount(2);
+    for (int row = 0; row < 4; row++) {
+        m_model.setData(m_model.index(row, 0), row + 1.0);
+        m_model.setData(m_model.index(row, 1), 10.0 * (row + 1));
+    }
+}
+
+void TestModelDataCache::testStorage()
+{
+    CellStorage<double> storage;
+    storage.reset(3, 2);
+    QCOMPARE(storage.rowCount(), 3);
+    QCOMPARE(storage.columnCount(), 2);
+    QVERIFY(!storage.isValid(0, 0));
+
+    for (int row = 0; row < 3; row++) {
+        storage.setValue(row, 0, row);
+        storage.setValue(row, 1, 10 * row);
+    }
+
+    // Grows the storage, then reuses the gap
+    storage.insertRows(1, 2);
+    storage.insertRows(3, 1);
+    QCOMPARE(storage.rowCount(), 6);
+    QVERIFY(storage.isValid(0, 0));
+    QVERIFY(!storage.isValid(1, 0));
+    QVERIFY(!storage.isValid(3, 1));
+    QCOMPARE(storage.value(4, 0), 1.0);
+    QCOMPARE(storage.value(5, 1), 20.0);
+
+    storage.removeRows(0, 2);
+    QCOMPARE(storage.rowCount(), 4);
+    QVERIFY(!storage.isValid(0, 0));
+    QCOMPARE(storage.value(2, 1), 10.0);
+
+    storage.insertColumns(1, 1);
+    QCOMPARE(storage.columnCount(), 3);
+    QVERIFY(!storage.isValid(2, 1));
+    QCOMPARE(storage.value(2, 2), 10.0);
+    storage.removeColumns(0, 2);
+    QCOMPARE(storage.value(3, 0), 20.0);
+
+    storage.invalidate(3, 0);
+    QVERIFY(!storage.isValid(3, 0));
+}
+
+void TestModelDataCache::testModelChanges()
+{
+    ModelDataCache<double> cache;
+    cache.setModel(&m_model);
+    QCOMPARE(cache.data(m_model.index(1, 1)), 20.0);
+
+    m_model.insertRows(0, 2);
+    m_model.setData(m_model.index(0, 1), 5.0);
+    QCOMPARE(cache.data(m_model.index(0, 1)), 5.0);
+    QCOMPARE(cache.data(m_model.index(3, 1)), 20.0);
+
+    m_model.setData(m_model.index(3, 1), 25.0);
+    QCOMPARE(cache.data(m_model.index(3, 1)), 25.0);
+
+    m_model.removeRows(0, 3);
+    QCOMPARE(cache.data(m_model.index(0, 0)), 2.0);
+    QCOMPARE(cache.data(m_model.index(0, 1)), 25.0);
+
+    m_model.removeColumns(0, 1);
+    QCOMPARE(cache.data(m_model.index(1, 0)), 30.0);
+}
+
+void TestModelDataCache::testFillColumn()
+{
+    ModelDataCache<double> cache;
+    cache.setModel(&m_model);
+    cache.fillColumn(1);
+
+    // Served from the cache, even if the model changed behind its back
+    m_model.blockSignals(true);
+    m_model.setData(m_model.index(2, 1), 99.0);
+    m_model.blockSignals(false);
+    QCOMPARE(cache.data(m_model.index(2, 1)), 30.0);
+    QCOMPARE(cache.data(m_model.index(3, 1)), 40.0);
+}
+
+void TestModelDataCache::benchmarkFlatStorage()
+{
+    CellStorage<double> storage;
+    double sum = 0.0;
+    QBENCHMARK {
+        sum = exerciseStorage(storage);
+    }
+    QVERIFY(sum > 0.0);
+}
+
+void TestModelDataCache::benchmarkNestedStorage()
+{
+    NestedStorage storage;
+    double sum = 0.0;
+    QBENCHMARK {
+        sum = exerciseStorage(storage);
+    }
+    QVERIFY(sum > 0.0);
+}
+
+QTEST_MAIN(TestModelDataCache)
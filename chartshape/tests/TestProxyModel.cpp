@@ -32,6 +32,7 @@
 // KChart
 #include "DataSet.h"
 #include "CellRegion.h"
+#include "SingleModelHelper.h"
 
 
 namespace QTest {
@@ -599,4 +600,100 @@ void TestProxyModel::testThreeDimensions()
     QCOMPARE(dataSets[1]->categoryDataRegion(), CellRegion());
 }
 
+void TestProxyModel::testIncrementalStructureChanges()
+{
+    m_proxyModel.setDataDirection(Qt::Vertical);
+    m_proxyModel.setFirstColumnIsLabel(true);
+    m_proxyModel.setFirstRowIsLabel(true);
+
+    QList<DataSet*> dataSets = m_proxyModel.dataSets();
+    QCOMPARE(dataSets.size(), 4);
+    QCOMPARE(dataSets[1]->size(), 3);
+
+    // Appending a row adds a data point to every data set
+    m_sourceModel.insertRows(4, 1);
+    QVERIFY(m_proxyModel.tableRowsInserted(m_table, 4, 4));
+    QCOMPARE(m_proxyModel.dataSets(), dataSets);
+    QCOMPARE(dataSets[1]->size(), 4);
+    QCOMPARE(dataSets[1]->yDataRegion(), CellRegion(m_table, QRect(3, 2, 1, 4)));
+    QCOMPARE(dataSets[1]->categoryDataRegion(), CellRegion(m_table, QRect(1, 2, 1, 4)));
+    QCOMPARE(dataSets[1]->labelDataRegion(), CellRegion(m_table, QPoint(3, 1)));
+    QCOMPARE(m_proxyModel.cellRangeAddress(), CellRegion(m_table, QRect(1, 1, 5, 5)));
+
+    // So does inserting one in between data points
+    m_sourceModel.insertRows(2, 2);
+    QVERIFY(m_proxyModel.tableRowsInserted(m_table, 2, 3));
+    QCOMPARE(dataSets[1]->size(), 6);
+    QCOMPARE(dataSets[1]->yDataRegion(), CellRegion(m_table, QRect(3, 2, 1, 6)));
+
+    m_sourceModel.removeRows(1, 3);
+    QVERIFY(m_proxyModel.tableRowsRemoved(m_table, 1, 3));
+    QCOMPARE(dataSets[1]->size(), 3);
+    QCOMPARE(dataSets[1]->yDataRegion(), CellRegion(m_table, QRect(3, 2, 1, 3)));
+    QCOMPARE(m_proxyModel.cellRangeAddress(), CellRegion(m_table, QRect(1, 1, 5, 4)));
+
+    // These change the labels or the number of data sets
+    QVERIFY(!m_proxyModel.tableRowsInserted(m_table, 0, 0));
+    QVERIFY(!m_proxyModel.tableRowsRemoved(m_table, 0, 0));
+    QVERIFY(!m_proxyModel.tableColumnsInserted(m_table, 5, 5));
+    QVERIFY(!m_proxyModel.tableColumnsRemoved(m_table, 2, 2));
+    QCOMPARE(dataSets[1]->yDataRegion(), CellRegion(m_table, QRect(3, 2, 1, 3)));
+}
+
+void TestProxyModel::testStructureChangesOfOtherTables()
+{
+    ChartTableModel otherModel;
+    otherModel.setRowCount(4);
+    otherModel.setColumnCount(2);
+    Table *otherTable = m_source.add("Table2", &otherModel);
+
+    // Forwards the structure changes of the model like the chart shape does
+    SingleModelHelper helper(m_table, &m_proxyModel);
+
+    m_proxyModel.setDataDirection(Qt::Vertical);
+    m_proxyModel.setFirstColumnIsLabel(true);
+    m_proxyModel.setFirstRowIsLabel(true);
+
+    QList<DataSet*> dataSets = m_proxyModel.dataSets();
+    QCOMPARE(dataSets.size(), 4);
+
+    // The categories of the first data set come from another table
+    const CellRegion otherCategories(otherTable, QRect(1, 2, 1, 3));
+    dataSets[0]->setCategoryDataRegion(otherCategories);
+
+    m_sourceModel.insertRows(2, 1);
+    QCOMPARE(m_proxyModel.dataSets(), dataSets);
+    QCOMPARE(dataSets[0]->yDataRegion(), CellRegion(m_table, QRect(2, 2, 1, 4)));
+    QCOMPARE(dataSets[0]->categoryDataRegion(), otherCategories);
+    QCOMPARE(dataSets[1]->categoryDataRegion(), CellRegion(m_table, QRect(1, 2, 1, 4)));
+
+    m_sourceModel.removeRows(2, 1);
+    QCOMPARE(m_proxyModel.dataSets(), dataSets);
+    QCOMPARE(dataSets[0]->yDataRegion(), CellRegion(m_table, QRect(2, 2, 1, 3)));
+    QCOMPARE(dataSets[0]->categoryDataRegion(), otherCategories);
+
+    // Inserting between the labels and the data rebuilds the data sets
+    // from the selection, which now contains the new row
+    m_sourceModel.insertRows(1, 1);
+    dataSets = m_proxyModel.dataSets();
+    QCOMPARE(dataSets[0]->yDataRegion(), CellRegion(m_table, QRect(2, 2, 1, 4)));
+    QCOMPARE(dataSets[0]->categoryDataRegion(), CellRegion(m_table, QRect(1, 2, 1, 4)));
+    QCOMPARE(m_proxyModel.cellRangeAddress(), CellRegion(m_table, QRect(1, 1, 5, 5)));
+
+    // Without a label row, inserting at the first data line moves everything
+    m_proxyModel.setFirstRowIsLabel(false);
+    dataSets = m_proxyModel.dataSets();
+    dataSets[0]->setCategoryDataRegion(otherCategories);
+    QCOMPARE(dataSets[0]->yDataRegion(), CellRegion(m_table, QRect(2, 1, 1, 5)));
+
+    m_sourceModel.insertRows(0, 1);
+    QCOMPARE(m_proxyModel.dataSets(), dataSets);
+    QCOMPARE(dataSets[0]->yDataRegion(), CellRegion(m_table, QRect(2, 2, 1, 5)));
+    QCOMPARE(dataSets[0]->categoryDataRegion(), otherCategories);
+    QCOMPARE(dataSets[1]->categoryDataRegion(), CellRegion(m_table, QRect(1, 2, 1, 5)));
+    QCOMPARE(m_proxyModel.cellRangeAddress(), CellRegion(m_table, QRect(1, 2, 5, 5)));
+
+    m_source.remove("Table2");
+}
+
 QTEST_MAIN(TestProxyModel)
@@ -47,6 +47,8 @@ private slots:
     void testComplexRegions();
     void testTwoDimensions();
     void testThreeDimensions();
+    void testIncrementalStructureChanges();
+    void testStructureChangesOfOtherTables();
 
 private:
     // m_source must be initialized before m_proxyModel